@@ -0,0 +1,267 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fixtures.h"
+#include "logger.h"
+#include "nbt.h"
+#include "nbt_reader.h"
+#include "world/block_storage.h"
+#include "world/chunk.h"
+#include "world/chunk_key.h"
+#include "world/record_key.h"
+#include "world/world.h"
+
+/**
+	Hot path benchmarks. Every fixture is generated in memory or in the temp directory, so the suite runs offline.
+	Throughput is reported as items/s (keys, blocks or records) and bytes/s.
+
+	Set SBP_BENCH_WORLD to a world directory to additionally time a full ParseDB over a recorded world.
+*/
+namespace {
+	using namespace smokey_bedrock_parser;
+	using namespace smokey_bedrock_parser::bench;
+
+	std::vector<std::string> BuildKeys() {
+		std::vector<std::string> keys;
+
+		for (int32_t x = -8; x < 8; x++) {
+			for (int32_t z = -8; z < 8; z++) {
+				keys.push_back(BuildChunkKey(x * 1000, z * 1000, 0, 44));
+				keys.push_back(BuildChunkKey(x, z, 0, 47, 3));
+				keys.push_back(BuildChunkKey(x, z, 1, 47, 2));
+				keys.push_back(BuildChunkKey(x, z, 2, 43));
+			}
+		}
+
+		keys.push_back("~local_player");
+		keys.push_back("BiomeData");
+		keys.push_back("VILLAGE_Overworld_6c4fb9b8-9f2a-4bd0-b9a3-0e5a6e2c3f11_INFO");
+		keys.push_back("actorprefix12345678");
+
+		return keys;
+	}
+
+	void BM_IsChunkKey(benchmark::State& state) {
+		std::vector<std::string> keys = BuildKeys();
+		uint64_t bytes = 0;
+
+		for (const auto& key : keys)
+			bytes += key.size();
+
+		for (auto _ : state)
+			for (const auto& key : keys)
+				benchmark::DoNotOptimize(IsChunkKey(key));
+
+		state.SetItemsProcessed(state.iterations() * keys.size());
+		state.SetBytesProcessed(state.iterations() * bytes);
+	}
+	BENCHMARK(BM_IsChunkKey);
+
+	void BM_DecodeChunkKey(benchmark::State& state) {
+		std::vector<std::string> keys;
+
+		for (const auto& key : BuildKeys())
+			if (IsChunkKey(key).first)
+				keys.push_back(key);
+
+		ChunkKey chunk_key;
+
+		for (auto _ : state)
+			for (const auto& key : keys) {
+				DecodeChunkKey(key, chunk_key);
+				benchmark::DoNotOptimize(chunk_key);
+			}
+
+		state.SetItemsProcessed(state.iterations() * keys.size());
+	}
+	BENCHMARK(BM_DecodeChunkKey);
+
+	void BM_ClassifyRecordKey(benchmark::State& state) {
+		std::vector<std::string> keys = BuildKeys();
+
+		for (auto _ : state)
+			for (const auto& key : keys)
+				benchmark::DoNotOptimize(ClassifyRecordKey(key));
+
+		state.SetItemsProcessed(state.iterations() * keys.size());
+	}
+	BENCHMARK(BM_ClassifyRecordKey);
+
+	void ForEachWidth(benchmark::internal::Benchmark* benchmark) {
+		for (int32_t bits_per_block : block_storage_widths)
+			benchmark->Arg(bits_per_block);
+	}
+
+	void BM_UnpackBlockStorage(benchmark::State& state) {
+		int32_t bits_per_block = (int32_t)state.range(0);
+		std::string sub_chunk = BuildSubChunk(bits_per_block, 0, 42);
+		uint16_t indices[kBlockStorageSize];
+
+		for (auto _ : state) {
+			const BlockStorageFormat* format;
+			int32_t block_offset, palette_offset;
+
+			SetupBlockStorage(sub_chunk.data(), format, block_offset, palette_offset);
+			format->unpack(sub_chunk.data() + block_offset, indices);
+			benchmark::DoNotOptimize(indices);
+		}
+
+		state.SetItemsProcessed(state.iterations() * kBlockStorageSize);
+		state.SetBytesProcessed(state.iterations() * GetBlockStorageFormat(uint8_t(bits_per_block << 1))->word_count * 4);
+	}
+	BENCHMARK(BM_UnpackBlockStorage)->Apply(ForEachWidth);
+
+	void BM_BlockStorageGet(benchmark::State& state) {
+		int32_t bits_per_block = (int32_t)state.range(0);
+		std::string words = BuildBlockStorageWords(bits_per_block, 2, 42);
+		const BlockStorageFormat* format = GetBlockStorageFormat(uint8_t(bits_per_block << 1));
+
+		for (auto _ : state) {
+			uint32_t sum = 0;
+
+			for (int32_t i = 0; i < kBlockStorageSize; i++)
+				sum += format->get(words.data(), i);
+
+			benchmark::DoNotOptimize(sum);
+		}
+
+		state.SetItemsProcessed(state.iterations() * kBlockStorageSize);
+		state.SetBytesProcessed(state.iterations() * words.size());
+	}
+	BENCHMARK(BM_BlockStorageGet)->Apply(ForEachWidth);
+
+	void BM_ParseChunk(benchmark::State& state) {
+		std::string sub_chunk = BuildSubChunk((int32_t)state.range(0), 0, 42);
+		Chunk chunk;
+
+		for (auto _ : state)
+			benchmark::DoNotOptimize(chunk.ParseChunk(0, 0, 0, sub_chunk.data(), sub_chunk.size(), 0, "overworld"));
+
+		state.SetItemsProcessed(state.iterations() * kBlockStorageSize);
+		state.SetBytesProcessed(state.iterations() * sub_chunk.size());
+	}
+	BENCHMARK(BM_ParseChunk)->Apply(ForEachWidth);
+
+	void BM_ParseNbtPalette(benchmark::State& state) {
+		std::string palette = BuildPalette((int32_t)state.range(0));
+		NbtTagList tag_list;
+
+		for (auto _ : state)
+			benchmark::DoNotOptimize(ParseNbt("", palette.data(), (int32_t)palette.size(), tag_list));
+
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+		state.SetBytesProcessed(state.iterations() * palette.size());
+	}
+	BENCHMARK(BM_ParseNbtPalette)->Arg(2)->Arg(16)->Arg(256);
+
+	void BM_NbtReaderPalette(benchmark::State& state) {
+		std::string palette = BuildPalette((int32_t)state.range(0));
+
+		for (auto _ : state) {
+			NbtReader reader(palette.data(), palette.size());
+			size_t name_bytes = 0;
+
+			while (!reader.at_end() && reader.ok()) {
+				NbtTagType type;
+				std::string_view name;
+
+				reader.ReadTagHeader(type, name);
+				reader.ForEachInCompound([&](NbtTagType child_type, std::string_view child_name) {
+					if (child_type == NbtTagType::String && child_name == "name") {
+						std::string_view value;
+
+						reader.ReadString(value);
+						name_bytes += value.size();
+
+						return true;
+					}
+
+					return reader.SkipPayload(child_type);
+				});
+			}
+
+			benchmark::DoNotOptimize(name_bytes);
+		}
+
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+		state.SetBytesProcessed(state.iterations() * palette.size());
+	}
+	BENCHMARK(BM_NbtReaderPalette)->Arg(2)->Arg(16)->Arg(256);
+
+	void BM_ParseNbtActor(benchmark::State& state) {
+		std::string actor = BuildActor(1);
+		NbtTagList tag_list;
+
+		for (auto _ : state)
+			benchmark::DoNotOptimize(ParseNbt("", actor.data(), (int32_t)actor.size(), tag_list));
+
+		state.SetItemsProcessed(state.iterations());
+		state.SetBytesProcessed(state.iterations() * actor.size());
+	}
+	BENCHMARK(BM_ParseNbtActor);
+
+	void RunParseDB(benchmark::State& state, const std::string& world_directory, int32_t record_count, uint64_t value_bytes) {
+		int32_t parsed_records = 0;
+
+		for (auto _ : state) {
+			state.PauseTiming();
+			auto level_db = std::make_unique<MinecraftWorldLevelDB>();
+			level_db->set_thread_count((int32_t)state.range(0));
+			level_db->init(world_directory);
+			level_db->OpenDB(world_directory);
+			state.ResumeTiming();
+
+			level_db->ParseDB();
+			parsed_records = level_db->get_parsed_record_count();
+
+			state.PauseTiming();
+			level_db.reset();
+			state.ResumeTiming();
+		}
+
+		if (record_count == 0)
+			record_count = parsed_records;
+
+		state.SetItemsProcessed(state.iterations() * record_count);
+
+		if (value_bytes != 0)
+			state.SetBytesProcessed(state.iterations() * value_bytes);
+	}
+
+	void BM_ParseDB(benchmark::State& state) {
+		static const FixtureWorld fixture = CreateFixtureWorld(std::filesystem::temp_directory_path() / "sbp_bench_world", 16, 8);
+
+		RunParseDB(state, fixture.directory.string(), fixture.record_count, fixture.value_bytes);
+	}
+	BENCHMARK(BM_ParseDB)->Arg(1)->Arg(2)->Arg(4)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+} // namespace
+
+int main(int argc, char** argv) {
+	// Measure parsing, not log formatting
+	smokey_bedrock_parser::SetupLoggerStage1();
+	spdlog::set_level(spdlog::level::off);
+
+	const char* recorded_world = getenv("SBP_BENCH_WORLD");
+
+	if (recorded_world != nullptr && *recorded_world != '\0') {
+		std::string world_directory = recorded_world;
+
+		benchmark::RegisterBenchmark("BM_ParseDB_Recorded", [world_directory](benchmark::State& state) {
+			RunParseDB(state, world_directory, 0, 0);
+		})->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(1);
+	}
+
+	benchmark::Initialize(&argc, argv);
+
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	return 0;
+}
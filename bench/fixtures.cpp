@@ -0,0 +1,288 @@
+#include "fixtures.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <leveldb/db.h>
+#include <leveldb/write_batch.h>
+#include <leveldb/zlib_compressor.h>
+#include <memory>
+#include <random>
+
+#include "world/block_storage.h"
+
+namespace smokey_bedrock_parser {
+	namespace bench {
+		const std::vector<int32_t> block_storage_widths{ 1, 2, 3, 4, 5, 6, 8, 16 };
+
+		void NbtWriter::Header(uint8_t type, const std::string& name) {
+			Raw(type);
+			Raw(uint16_t(name.size()));
+			buffer.append(name);
+		}
+
+		void NbtWriter::BeginCompound(const std::string& name) {
+			Header(10, name);
+		}
+
+		void NbtWriter::EndCompound() {
+			Raw(uint8_t(0));
+		}
+
+		void NbtWriter::BeginList(const std::string& name, uint8_t element_type, int32_t count) {
+			Header(9, name);
+			Raw(element_type);
+			Raw(count);
+		}
+
+		void NbtWriter::String(const std::string& name, const std::string& value) {
+			Header(8, name);
+			StringPayload(value);
+		}
+
+		void NbtWriter::Byte(const std::string& name, int8_t value) {
+			Header(1, name);
+			Raw(value);
+		}
+
+		void NbtWriter::Int(const std::string& name, int32_t value) {
+			Header(3, name);
+			Raw(value);
+		}
+
+		void NbtWriter::Long(const std::string& name, int64_t value) {
+			Header(4, name);
+			Raw(value);
+		}
+
+		void NbtWriter::Float(const std::string& name, float value) {
+			Header(5, name);
+			Raw(value);
+		}
+
+		void NbtWriter::StringPayload(const std::string& value) {
+			Raw(uint16_t(value.size()));
+			buffer.append(value);
+		}
+
+		void NbtWriter::FloatPayload(float value) {
+			Raw(value);
+		}
+
+		std::string BuildPaletteEntry(int32_t index) {
+			static const char* names[] = {
+				"minecraft:air", "minecraft:stone", "minecraft:dirt", "minecraft:grass_block", "minecraft:oak_log",
+				"minecraft:water", "minecraft:deepslate", "minecraft:gravel"
+			};
+			static const char* axes[] = { "x", "y", "z" };
+			NbtWriter writer;
+
+			writer.BeginCompound("");
+			writer.String("name", names[index % 8]);
+			writer.BeginCompound("states");
+			writer.String("pillar_axis", axes[index % 3]);
+			writer.Int("variant", index);
+			writer.Byte("waterlogged", int8_t(index & 1));
+			writer.EndCompound();
+			writer.Int("version", 18105860);
+			writer.EndCompound();
+
+			return writer.buffer;
+		}
+
+		std::string BuildPalette(int32_t palette_size) {
+			std::string palette;
+
+			for (int32_t i = 0; i < palette_size; i++)
+				palette += BuildPaletteEntry(i);
+
+			return palette;
+		}
+
+		std::string BuildActor(int64_t unique_id) {
+			NbtWriter writer;
+
+			writer.BeginCompound("");
+			writer.String("identifier", "minecraft:zombie");
+			writer.BeginList("definitions", 8, 2);
+			writer.StringPayload("+minecraft:zombie");
+			writer.StringPayload("+zombie_adult");
+			writer.BeginList("Pos", 5, 3);
+			writer.FloatPayload(12.5f);
+			writer.FloatPayload(64.0f);
+			writer.FloatPayload(-7.5f);
+			writer.BeginList("Rotation", 5, 2);
+			writer.FloatPayload(90.0f);
+			writer.FloatPayload(0.0f);
+			writer.BeginList("Motion", 5, 3);
+			writer.FloatPayload(0.0f);
+			writer.FloatPayload(-0.08f);
+			writer.FloatPayload(0.0f);
+			writer.Long("UniqueID", unique_id);
+			writer.Byte("OnGround", 1);
+			writer.Int("Variant", 0);
+			writer.BeginList("Attributes", 10, 4);
+
+			for (const char* name : { "minecraft:health", "minecraft:movement", "minecraft:follow_range", "minecraft:attack_damage" }) {
+				writer.String("Name", name);
+				writer.Float("Base", 20.0f);
+				writer.Float("Current", 20.0f);
+				writer.Float("Max", 20.0f);
+				writer.EndCompound();
+			}
+
+			writer.EndCompound();
+
+			return writer.buffer;
+		}
+
+		std::string BuildBlockStorageWords(int32_t bits_per_block, int32_t palette_size, uint32_t seed) {
+			const BlockStorageFormat* format = GetBlockStorageFormat(uint8_t(bits_per_block << 1));
+			std::string words(format->word_count * 4, '\0');
+			std::mt19937 random(seed);
+
+			for (int32_t i = 0; i < kBlockStorageSize && format->blocks_per_word > 0; i++) {
+				uint32_t value = random() % palette_size;
+				int32_t word_index = i / format->blocks_per_word;
+				uint32_t word;
+
+				memcpy(&word, &words[word_index * 4], 4);
+				word |= value << ((i % format->blocks_per_word) * bits_per_block);
+				memcpy(&words[word_index * 4], &word, 4);
+			}
+
+			return words;
+		}
+
+		std::string BuildSubChunk(int32_t bits_per_block, int8_t y_index, uint32_t seed) {
+			// Real palettes are small, even a 16 bit storage rarely has more than a few hundred entries
+			int32_t palette_size = bits_per_block == 0 ? 1 : std::min(1 << bits_per_block, 256);
+			std::string value;
+
+			value.push_back(0x09);
+			value.push_back(0x01);
+			value.push_back(char(y_index));
+			value.push_back(char(bits_per_block << 1));
+			value += BuildBlockStorageWords(bits_per_block, palette_size, seed);
+			value.append((const char*)&palette_size, 4);
+			value += BuildPalette(palette_size);
+
+			return value;
+		}
+
+		std::string BuildChunkKey(int32_t chunk_x, int32_t chunk_z, int32_t dimension_id, char tag, int32_t sub_chunk) {
+			std::string key;
+
+			key.append((const char*)&chunk_x, 4);
+			key.append((const char*)&chunk_z, 4);
+
+			if (dimension_id != 0)
+				key.append((const char*)&dimension_id, 4);
+
+			key.push_back(tag);
+
+			if (sub_chunk >= 0)
+				key.push_back(char(sub_chunk));
+
+			return key;
+		}
+
+		namespace {
+			void WriteLevelFiles(const std::filesystem::path& directory) {
+				NbtWriter writer;
+
+				writer.BeginCompound("");
+				writer.String("LevelName", "Benchmark Fixture");
+				writer.Int("SpawnX", 0);
+				writer.Int("SpawnY", 64);
+				writer.Int("SpawnZ", 0);
+				writer.Long("RandomSeed", 1234567890);
+				writer.EndCompound();
+
+				int32_t header[2] = { 10, (int32_t)writer.buffer.size() };
+				FILE* file = fopen((directory / "level.dat").string().c_str(), "wb");
+
+				fwrite(header, sizeof(header), 1, file);
+				fwrite(writer.buffer.data(), 1, writer.buffer.size(), file);
+				fclose(file);
+
+				file = fopen((directory / "levelname.txt").string().c_str(), "w");
+				fputs("Benchmark Fixture", file);
+				fclose(file);
+			}
+		} // namespace
+
+		FixtureWorld CreateFixtureWorld(const std::filesystem::path& directory, int32_t chunk_radius, int32_t sub_chunk_count) {
+			FixtureWorld fixture;
+			fixture.directory = directory;
+
+			std::filesystem::remove_all(directory);
+			std::filesystem::create_directories(directory);
+			WriteLevelFiles(directory);
+
+			// Same on-disk format the game writes: raw zlib compressed blocks
+			leveldb::Options options;
+			auto compressor = std::make_unique<leveldb::ZlibCompressorRaw>(-1);
+			options.create_if_missing = true;
+			options.compressors[0] = compressor.get();
+
+			leveldb::DB* db = nullptr;
+			leveldb::Status status = leveldb::DB::Open(options, (directory / "db").string(), &db);
+
+			if (!status.ok()) {
+				fprintf(stderr, "Failed to create fixture world: %s\n", status.ToString().c_str());
+
+				return fixture;
+			}
+
+			auto put = [&](leveldb::WriteBatch& batch, const std::string& key, const std::string& value) {
+				batch.Put(key, value);
+				fixture.record_count++;
+				fixture.value_bytes += value.size();
+			};
+
+			std::string data_3d(512 + 256, '\0');
+			int64_t next_actor_id = 1;
+
+			for (int32_t x = -chunk_radius; x < chunk_radius; x++) {
+				leveldb::WriteBatch batch;
+
+				for (int32_t z = -chunk_radius; z < chunk_radius; z++) {
+					put(batch, BuildChunkKey(x, z, 0, 44), std::string(1, char(40)));
+					put(batch, BuildChunkKey(x, z, 0, 43), data_3d);
+
+					for (int32_t y = 0; y < sub_chunk_count; y++) {
+						int32_t bits_per_block = block_storage_widths[(x + z + y + 3 * chunk_radius) % block_storage_widths.size()];
+
+						put(batch, BuildChunkKey(x, z, 0, 47, y), BuildSubChunk(bits_per_block, int8_t(y), uint32_t(x * 31 + z * 17 + y)));
+					}
+
+					// Two actors in every fourth chunk
+					if (((x + z) & 3) == 0) {
+						std::string digp_key = "digp" + BuildChunkKey(x, z, 0, 0).substr(0, 8);
+						std::string actor_ids;
+
+						for (int32_t i = 0; i < 2; i++) {
+							int64_t actor_id = next_actor_id++;
+							std::string actor_key = "actorprefix";
+
+							actor_key.append((const char*)&actor_id, 8);
+							actor_ids.append((const char*)&actor_id, 8);
+							put(batch, actor_key, BuildActor(actor_id));
+						}
+
+						put(batch, digp_key, actor_ids);
+					}
+				}
+
+				db->Write(leveldb::WriteOptions(), &batch);
+			}
+
+			// Push everything into SST files so reads go through the block cache and decompression like a real world
+			db->CompactRange(nullptr, nullptr);
+			delete db;
+
+			return fixture;
+		}
+	} // namespace bench
+} // namespace smokey_bedrock_parser
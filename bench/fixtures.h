@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace smokey_bedrock_parser {
+	namespace bench {
+		// Little-endian NBT writer for building payloads in memory
+		class NbtWriter {
+		public:
+			std::string buffer;
+
+			void BeginCompound(const std::string& name);
+			void EndCompound();
+			void BeginList(const std::string& name, uint8_t element_type, int32_t count);
+			void String(const std::string& name, const std::string& value);
+			void Byte(const std::string& name, int8_t value);
+			void Int(const std::string& name, int32_t value);
+			void Long(const std::string& name, int64_t value);
+			void Float(const std::string& name, float value);
+
+			// Unnamed payloads, for list elements
+			void StringPayload(const std::string& value);
+			void FloatPayload(float value);
+
+		private:
+			void Header(uint8_t type, const std::string& name);
+
+			template <typename T>
+			void Raw(T value) {
+				buffer.append((const char*)&value, sizeof(T));
+			}
+		};
+
+		// One root palette compound: name, states and version
+		std::string BuildPaletteEntry(int32_t index);
+
+		// palette_size root compounds back to back, without the leading size
+		std::string BuildPalette(int32_t palette_size);
+
+		// A typical mob record as stored under actorprefix
+		std::string BuildActor(int64_t unique_id);
+
+		// The packed index words of one block storage with random indices below palette_size
+		std::string BuildBlockStorageWords(int32_t bits_per_block, int32_t palette_size, uint32_t seed);
+
+		// A complete v9 SubChunkPrefix value with one block storage
+		std::string BuildSubChunk(int32_t bits_per_block, int8_t y_index, uint32_t seed);
+
+		std::string BuildChunkKey(int32_t chunk_x, int32_t chunk_z, int32_t dimension_id, char tag, int32_t sub_chunk = -1);
+
+		struct FixtureWorld {
+			std::filesystem::path directory;
+			int32_t record_count = 0;
+			uint64_t value_bytes = 0;
+		};
+
+		/**
+			Writes a world with level.dat, levelname.txt and a LevelDB of (2 * chunk_radius)^2 overworld chunks,
+			each with a version record, a Data3D record, sub_chunk_count sub-chunks cycling through every
+			bits-per-block width, and a few actors. Uses the bundled leveldb-mcpe, so it works offline.
+		*/
+		FixtureWorld CreateFixtureWorld(const std::filesystem::path& directory, int32_t chunk_radius, int32_t sub_chunk_count);
+
+		// Sub-chunk widths Bedrock writes
+		extern const std::vector<int32_t> block_storage_widths;
+	} // namespace bench
+} // namespace smokey_bedrock_parser
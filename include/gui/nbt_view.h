@@ -0,0 +1,8 @@
+#pragma once
+
+#include "nbt.h"
+
+namespace smokey_bedrock_parser {
+	// Draws the tags as a two column ImGui tree. Needs a current ImGui frame and a 2 column layout.
+	void RenderNbt(const NbtTagList& tag_list);
+} // namespace smokey_bedrock_parser
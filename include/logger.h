@@ -1,27 +1,105 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <spdlog/spdlog.h>
 
+/**
+	Lowest level the SBP_LOG_* macros keep, as a Level value (0 = trace ... 4 = error). Anything below it is
+	compiled out, arguments included. Set through the SBP_MAX_LOG_LEVEL CMake option.
+*/
+#ifndef SBP_MAX_LOG_LEVEL
+#define SBP_MAX_LOG_LEVEL 0
+#endif
+
 namespace smokey_bedrock_parser {
+	enum class Level {
+		Trace = spdlog::level::trace,
+		Debug = spdlog::level::debug,
+		Info = spdlog::level::info,
+		Warn = spdlog::level::warn,
+		Error = spdlog::level::err
+	};
+
 	namespace log {
 		using spdlog::trace;
 		using spdlog::debug;
 		using spdlog::info;
 		using spdlog::warn;
 		using spdlog::error;
+
+		constexpr bool compiled_in(Level level) {
+			return int(level) >= SBP_MAX_LOG_LEVEL;
+		}
+
+		// Whether a message at level would be written anywhere, use it to skip work that only feeds a log call
+		inline bool enabled(Level level) {
+			return compiled_in(level) && spdlog::default_logger_raw()->should_log(spdlog::level::level_enum(level));
+		}
 	}
 
-	enum class Level {
-		Trace = spdlog::level::trace,
-		Debug = spdlog::level::debug,
-		Info = spdlog::level::info,
-		Warn = spdlog::level::warn,
-		Error = spdlog::level::err
+	/**
+		Moves sink I/O off the calling threads: messages are queued and written by spdlog's background thread, so a
+		scan thread never waits on the log file or the sink mutex.
+	*/
+	struct AsyncLogOptions {
+		bool enabled = false;
+		// Messages that can be queued before the overflow policy kicks in
+		size_t queue_size = 8192;
+		// Wait for room when the queue is full, or overwrite the oldest queued message
+		bool block_when_full = true;
 	};
 
 	void SetupLoggerStage1();
 
-	void SetupLoggerStage2(const std::filesystem::path& outdir, Level consoleLevel, Level fileLevel);
+	void SetupLoggerStage2(const std::filesystem::path& outdir, Level consoleLevel, Level fileLevel,
+		const AsyncLogOptions& async_options = AsyncLogOptions());
+
+	// Flushes and stops the logger, call before exiting when async logging is on so queued messages are written
+	void ShutdownLogger();
+
+	/**
+		Lets at most one caller through per interval, from any number of threads. For progress messages that
+		should not depend on how fast records come in.
+	*/
+	class ProgressReporter {
+	public:
+		explicit ProgressReporter(std::chrono::milliseconds interval = std::chrono::seconds(1))
+			: interval(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count()), next_report(0) {}
+
+		bool ShouldReport() {
+			int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+			int64_t next = next_report.load(std::memory_order_relaxed);
+
+			// Only the thread that moves next_report forward gets to report
+			return now >= next && next_report.compare_exchange_strong(next, now + interval, std::memory_order_relaxed);
+		}
+
+	private:
+		int64_t interval;
+		std::atomic<int64_t> next_report;
+	};
+
+} // namespace smokey_bedrock_parser
+
+/**
+	Logging for hot paths. Unlike log::info and friends the arguments are only evaluated, and the message only
+	formatted, if the level is compiled in and enabled at runtime.
+*/
+#define SBP_LOG(log_level, ...) \
+	do { \
+		if constexpr (::smokey_bedrock_parser::log::compiled_in(log_level)) { \
+			if (::smokey_bedrock_parser::log::enabled(log_level)) \
+				::spdlog::default_logger_raw()->log(::spdlog::level::level_enum(log_level), __VA_ARGS__); \
+		} \
+	} while (0)
 
-} // namespace smokey_bedrock_parser
\ No newline at end of file
+#define SBP_LOG_TRACE(...) SBP_LOG(::smokey_bedrock_parser::Level::Trace, __VA_ARGS__)
+#define SBP_LOG_DEBUG(...) SBP_LOG(::smokey_bedrock_parser::Level::Debug, __VA_ARGS__)
+#define SBP_LOG_INFO(...) SBP_LOG(::smokey_bedrock_parser::Level::Info, __VA_ARGS__)
+#define SBP_LOG_WARN(...) SBP_LOG(::smokey_bedrock_parser::Level::Warn, __VA_ARGS__)
+#define SBP_LOG_ERROR(...) SBP_LOG(::smokey_bedrock_parser::Level::Error, __VA_ARGS__)
\ No newline at end of file
@@ -4,11 +4,6 @@
 #include "nbt_tags.h"
 
 namespace smokey_bedrock_parser {
-	typedef struct NbtJson {
-		std::string name;
-		nlohmann::json nbt;
-	};
-
 	class PlayerInfo {
 	public:
 		int64_t unique_id;
@@ -18,7 +13,37 @@ namespace smokey_bedrock_parser {
 	typedef std::pair<std::string, std::unique_ptr<nbt::tag>> NbtTag;
 	typedef std::vector<NbtTag> NbtTagList;
 
-	std::pair<int32_t, nlohmann::json> ParseNbt(const char* header, const char* buffer, int32_t buffer_length, NbtTagList& tag_list);
+	/**
+		Receives the decoded tag tree from VisitNbt. List elements are visited with an empty name.
+	*/
+	class NbtVisitor {
+	public:
+		virtual ~NbtVisitor() = default;
+
+		// Every tag that is not a list or a compound
+		virtual void Value(const std::string& name, const nbt::tag& tag) = 0;
+
+		// Lists and compounds. Returning false skips the children and the matching EndContainer call.
+		virtual bool BeginContainer(const std::string& name, const nbt::tag& tag) = 0;
+
+		virtual void EndContainer(const std::string& name, const nbt::tag& tag) = 0;
+	};
+
+	/**
+		Decodes every root tag in buffer into tag_list. Builds no JSON, makes no UI calls and touches no shared
+		state, so the ParseDB decode workers can call it concurrently. Keep it that way: the ImGui context is not
+		thread-safe and only the GUI thread may render, through an NbtVisitor.
+	*/
+	int32_t ParseNbt(const char* header, const char* buffer, int32_t buffer_length, NbtTagList& tag_list);
+
+	// Walks the decoded tags in order without copying them
+	void VisitNbt(const NbtTagList& tag_list, NbtVisitor& visitor);
+
+	// JSON value of a single non-container tag
+	nlohmann::json NbtValueToJson(const nbt::tag& tag);
+
+	// One JSON object per root tag, lists become arrays and compounds objects
+	nlohmann::json NbtToJson(const NbtTagList& tag_list);
 	
 	int32_t ParseNbtVillage(NbtTagList& tags_info, NbtTagList& tags_player, NbtTagList& tags_dweller, NbtTagList& tags_poi);
 } // namespace smokey_bedrock_parser
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace smokey_bedrock_parser {
+	// Tag ids as they appear on disk
+	enum class NbtTagType : uint8_t {
+		End = 0,
+		Byte,
+		Short,
+		Int,
+		Long,
+		Float,
+		Double,
+		ByteArray,
+		String,
+		List,
+		Compound,
+		IntArray,
+		LongArray
+	};
+
+	/**
+		Forward-only reader for Bedrock's little-endian NBT that works directly on the bytes of a LevelDB value.
+
+		Nothing is copied: strings come back as views into the buffer, so names can be compared without
+		allocating. Every Read* call returns false once the data is truncated or malformed and the reader stays in
+		that failed state, so callers can check once after a run of reads.
+	*/
+	class NbtReader {
+	public:
+		NbtReader(const char* buffer, size_t buffer_length) : buffer(buffer), buffer_length(buffer_length), offset(0), failed(false) {}
+
+		bool ok() const {
+			return !failed;
+		}
+
+		bool at_end() const {
+			return offset >= buffer_length;
+		}
+
+		size_t position() const {
+			return offset;
+		}
+
+		const char* data() const {
+			return buffer + offset;
+		}
+
+		// Reads the type and name of the next tag. An End tag has no name.
+		bool ReadTagHeader(NbtTagType& type, std::string_view& name);
+
+		bool ReadByte(int8_t& value) {
+			return ReadScalar(value);
+		}
+
+		bool ReadShort(int16_t& value) {
+			return ReadScalar(value);
+		}
+
+		bool ReadInt(int32_t& value) {
+			return ReadScalar(value);
+		}
+
+		bool ReadLong(int64_t& value) {
+			return ReadScalar(value);
+		}
+
+		bool ReadFloat(float& value) {
+			return ReadScalar(value);
+		}
+
+		bool ReadDouble(double& value) {
+			return ReadScalar(value);
+		}
+
+		bool ReadString(std::string_view& value);
+
+		bool ReadListHeader(NbtTagType& element_type, int32_t& count);
+
+		// For ByteArray, IntArray and LongArray payloads. data points at count little-endian elements in the buffer.
+		bool ReadArray(NbtTagType type, int32_t& count, const char*& data);
+
+		// Skips the payload of a tag whose header has already been read
+		bool SkipPayload(NbtTagType type) {
+			return SkipPayload(type, 0);
+		}
+
+		// Skips a whole named tag, header included
+		bool SkipTag();
+
+		/**
+			Walks the children of a compound whose header has already been read, stopping at its End tag.
+			visit(type, name) is called for every child and must consume the payload, either by reading it or with
+			SkipPayload, and return false to abort.
+		*/
+		template <typename Visitor>
+		bool ForEachInCompound(Visitor&& visit) {
+			NbtTagType type;
+			std::string_view name;
+
+			while (ReadTagHeader(type, name)) {
+				if (type == NbtTagType::End)
+					return true;
+
+				if (!visit(type, name))
+					return false;
+			}
+
+			return false;
+		}
+
+	private:
+		const char* buffer;
+		size_t buffer_length;
+		size_t offset;
+		bool failed;
+
+		bool Fail() {
+			failed = true;
+
+			return false;
+		}
+
+		bool Advance(size_t count) {
+			if (failed || count > buffer_length - offset) return Fail();
+
+			offset += count;
+
+			return true;
+		}
+
+		template <typename T>
+		bool ReadScalar(T& value) {
+			if (failed || sizeof(T) > buffer_length - offset) return Fail();
+
+			memcpy(&value, buffer + offset, sizeof(T));
+			offset += sizeof(T);
+
+			return true;
+		}
+
+		bool SkipPayload(NbtTagType type, int32_t depth);
+	};
+} // namespace smokey_bedrock_parser
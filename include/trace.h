@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace smokey_bedrock_parser {
+	/**
+		Timeline tracing in the Chrome trace-event format, which chrome://tracing and ui.perfetto.dev both load.
+
+		Spans are collected in per-thread buffers between Start and Stop, so recording one never contends with
+		another thread. While tracing is off a span costs one relaxed atomic load.
+	*/
+	namespace trace {
+		namespace detail {
+			extern std::atomic<bool> tracing;
+		}
+
+		inline bool enabled() {
+			return detail::tracing.load(std::memory_order_relaxed);
+		}
+
+		// Drops anything recorded by an earlier run and starts recording
+		void Start();
+
+		// Stops recording and writes everything recorded since Start to path. Returns 0 or -1.
+		int32_t Stop(const std::filesystem::path& path);
+
+		// Shown instead of the thread ID in the viewer. Only recorded while tracing.
+		void SetThreadName(const std::string& name);
+
+		// Microseconds since Start
+		double Now();
+
+		/**
+			Records one span from construction to destruction on the calling thread. name (and arg_name) must
+			outlive the trace, i.e. be string literals.
+		*/
+		class ScopedSpan {
+		public:
+			explicit ScopedSpan(const char* name) : name(enabled() ? name : nullptr) {
+				if (this->name != nullptr)
+					start = Now();
+			}
+
+			~ScopedSpan() {
+				if (name != nullptr)
+					End();
+			}
+
+			ScopedSpan(const ScopedSpan&) = delete;
+			ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+			// Attaches one number to the span, shown under its args
+			void set_arg(const char* arg_name, int64_t value) {
+				this->arg_name = arg_name;
+				arg_value = value;
+			}
+
+		private:
+			const char* name;
+			const char* arg_name = nullptr;
+			int64_t arg_value = 0;
+			double start = 0.0;
+
+			void End();
+		};
+	}
+} // namespace smokey_bedrock_parser
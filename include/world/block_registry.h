@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "world/block_state.h"
+
+namespace smokey_bedrock_parser {
+	// Returned for blocks that are out of range or were never interned
+	constexpr uint32_t kInvalidBlockId = UINT32_MAX;
+
+	/**
+		Process-wide dictionary of every (name, states) pair seen in a palette, each mapped to a dense 32-bit
+		runtime ID in the order it was first interned. States are decoded and keyed in canonical form, so the same
+		properties serialized in a different order share one ID.
+
+		Lookups never take a lock: each shard publishes its probe table through an atomic pointer, and the states
+		themselves live in fixed-size segments that never move once allocated. Only inserts take the mutex of the
+		one shard the key hashes to, so scan threads working on different blocks rarely contend.
+	*/
+	class BlockRegistry {
+	public:
+		static constexpr size_t kShardCount = 64;
+		static constexpr size_t kSegmentSize = 1024;
+		static constexpr size_t kMaxSegments = 4096;
+
+		BlockRegistry();
+		~BlockRegistry();
+		BlockRegistry(const BlockRegistry&) = delete;
+		BlockRegistry& operator=(const BlockRegistry&) = delete;
+
+		static BlockRegistry& Instance();
+
+		/**
+			Returns the ID of (name, states), adding it if it has not been seen yet. states is the raw payload of
+			the palette entry's "states" compound; it is only decoded if those exact bytes were never interned.
+		*/
+		uint32_t Intern(std::string_view name, std::string_view states);
+
+		// kInvalidBlockId if (name, states) has not been interned
+		uint32_t Find(std::string_view name, std::string_view states) const;
+
+		// id must have been returned by Intern or Find
+		const BlockState& get_state(uint32_t id) const {
+			return segments[id / kSegmentSize].load(std::memory_order_acquire)[id % kSegmentSize];
+		}
+
+		const std::string& get_name(uint32_t id) const {
+			return get_state(id).name;
+		}
+
+		uint32_t size() const {
+			return next_id.load(std::memory_order_acquire);
+		}
+
+	private:
+		// Open-addressing table; each slot is the upper 32 bits of the key hash and the ID + 1, 0 if empty
+		struct ProbeTable {
+			size_t mask;
+			std::unique_ptr<std::atomic<uint64_t>[]> slots;
+
+			explicit ProbeTable(size_t capacity);
+		};
+
+		struct Shard {
+			std::atomic<ProbeTable*> table{nullptr};
+			std::mutex mutex;
+			size_t count = 0;
+			// Tables replaced by a resize are kept alive because readers may still be probing them
+			std::vector<std::unique_ptr<ProbeTable>> tables;
+		};
+
+		std::array<Shard, kShardCount> shards;
+		std::unique_ptr<std::atomic<BlockState*>[]> segments;
+		std::atomic<uint32_t> next_id{0};
+
+		uint32_t Probe(const ProbeTable* table, uint64_t hash, std::string_view name, std::string_view states) const;
+
+		uint32_t FindExact(std::string_view name, std::string_view states) const;
+
+		static BlockState Canonicalize(std::string_view name, std::string_view states);
+
+		uint32_t Insert(BlockState&& state);
+
+		uint32_t Append(BlockState&& state);
+
+		void Grow(Shard& shard);
+	};
+} // namespace smokey_bedrock_parser
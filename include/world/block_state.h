@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "nbt_reader.h"
+
+namespace smokey_bedrock_parser {
+	// One entry of a palette's "states" compound, e.g. pillar_axis = "y" or open_bit = 1
+	struct BlockProperty {
+		std::string name;
+		// Byte, Int or String; bytes and ints are both kept in number
+		NbtTagType type = NbtTagType::End;
+		int32_t number = 0;
+		std::string text;
+
+		bool operator==(const BlockProperty& other) const {
+			return name == other.name && type == other.type && number == other.number && text == other.text;
+		}
+	};
+
+	struct BlockState {
+		std::string name;
+		// Canonical little-endian NBT payload of the "states" compound, properties sorted by name
+		std::string states;
+		std::vector<BlockProperty> properties;
+		// Same for two states with equal properties no matter the order they were serialized in
+		uint64_t state_hash = 0;
+
+		// nullptr if the block has no property called name
+		const BlockProperty* get_property(std::string_view name) const;
+	};
+
+	/**
+		Decodes the payload of a "states" compound (everything after its tag header, End tag included), or an empty
+		view for no states, into properties sorted by name. Returns false for malformed data or a property type Bedrock does not use.
+	*/
+	bool DecodeBlockStates(std::string_view states, std::vector<BlockProperty>& properties);
+
+	// Serializes sorted properties back into a "states" payload, the inverse of DecodeBlockStates
+	std::string EncodeBlockStates(const std::vector<BlockProperty>& properties);
+
+	// Order-independent hash of a set of properties
+	uint64_t HashBlockStates(const std::vector<BlockProperty>& properties);
+} // namespace smokey_bedrock_parser
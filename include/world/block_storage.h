@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace smokey_bedrock_parser {
+	// Number of blocks in one sub-chunk block storage (16 * 16 * 16)
+	constexpr int32_t kBlockStorageSize = 4096;
+
+	/**
+		Typed view over the packed palette indices of one block storage.
+
+		Bedrock packs floor(32 / Bits) indices into each little-endian 32-bit word, lowest bits first, and never
+		lets an index straddle two words. Every layout constant is known at compile time so the per-word loops can
+		be fully unrolled. Indices are in storage order, i.e. index = ((x * 16) + z) * 16 + y.
+	*/
+	template <int32_t Bits>
+	struct BlockStorageView {
+		static_assert(Bits > 0 && Bits <= 16, "Bedrock block storages use 1 to 16 bits per block");
+
+		static constexpr int32_t kBitsPerBlock = Bits;
+		static constexpr int32_t kBlocksPerWord = 32 / Bits;
+		static constexpr int32_t kWordCount = (kBlockStorageSize + kBlocksPerWord - 1) / kBlocksPerWord;
+		static constexpr int32_t kByteSize = kWordCount * 4;
+		static constexpr uint32_t kMask = (1u << Bits) - 1;
+
+		const char* words;
+
+		uint16_t Get(int32_t index) const {
+			uint32_t word;
+
+			memcpy(&word, words + (index / kBlocksPerWord) * 4, 4);
+
+			return uint16_t((word >> ((index % kBlocksPerWord) * Bits)) & kMask);
+		}
+
+		// Writes all kBlockStorageSize indices into indices
+		void Unpack(uint16_t* indices) const;
+	};
+
+	// A storage with a single palette entry has no index words at all
+	template <>
+	struct BlockStorageView<0> {
+		static constexpr int32_t kBitsPerBlock = 0;
+		static constexpr int32_t kBlocksPerWord = 0;
+		static constexpr int32_t kWordCount = 0;
+		static constexpr int32_t kByteSize = 0;
+		static constexpr uint32_t kMask = 0;
+
+		const char* words;
+
+		uint16_t Get(int32_t) const {
+			return 0;
+		}
+
+		void Unpack(uint16_t* indices) const {
+			memset(indices, 0, kBlockStorageSize * sizeof(uint16_t));
+		}
+	};
+
+	/**
+		Runtime description of a block storage layout, looked up once per storage from its header byte
+		([bits per block:7][runtime flag:1]). get and unpack forward to the matching BlockStorageView<Bits>.
+	*/
+	struct BlockStorageFormat {
+		int32_t bits_per_block;
+		int32_t blocks_per_word;
+		int32_t word_count;
+		uint16_t(*get)(const char* words, int32_t index);
+		void (*unpack)(const char* words, uint16_t* indices);
+	};
+
+	// Returns nullptr if header does not describe a known layout
+	const BlockStorageFormat* GetBlockStorageFormat(uint8_t header);
+
+	/**
+		Reads the sub-chunk version and storage header at the start of a SubChunkPrefix value. block_offset is set
+		to the first index word and palette_offset to the palette size that follows the words.
+	*/
+	int32_t SetupBlockStorage(const char* buffer, const BlockStorageFormat*& format, int32_t& block_offset, int32_t& palette_offset);
+} // namespace smokey_bedrock_parser
@@ -1,23 +1,89 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <vector>
+
+#include "world/block_registry.h"
+#include "world/block_storage.h"
 
 namespace smokey_bedrock_parser {
+	// One block storage layer of a sub-chunk, kept in the packed form it has on disk and decoded on demand
+	struct BlockStorage {
+		const BlockStorageFormat* format = nullptr;
+		std::vector<uint32_t> words;
+		// BlockRegistry IDs, so comparing blocks across sub-chunks is an integer compare
+		std::vector<uint32_t> palette;
+
+		// Palette index of the block at sub-chunk local coordinates
+		uint16_t GetIndex(int32_t x, int32_t y, int32_t z) const {
+			return format->get((const char*)words.data(), (((x * 16) + z) * 16) + y);
+		}
+
+		// Writes all kBlockStorageSize palette indices, in storage order
+		void Unpack(uint16_t* indices) const {
+			format->unpack((const char*)words.data(), indices);
+		}
+	};
+
+	struct SubChunk {
+		// Layer 0 holds the blocks, layer 1 (if present) mostly water for waterlogged blocks
+		std::vector<BlockStorage> storages;
+
+		bool empty() const {
+			return storages.empty();
+		}
+	};
+
 	class Chunk {
 	public:
+		// Sub-chunk indices of the overworld height range, y = -64 to 319
+		static constexpr int32_t kMinSubChunk = -4;
+		static constexpr int32_t kMaxSubChunk = 19;
+		static constexpr int32_t kSubChunkCount = kMaxSubChunk - kMinSubChunk + 1;
+
 		int32_t chunk_x, chunk_z;
-		uint16_t blocks[16][16];
 		int32_t chunk_format_version;
+		std::array<SubChunk, kSubChunkCount> sub_chunks;
+		// Raw Data3D and BlockEntity record values, decoded on demand. Only MinecraftWorldLevelDB::LoadChunk
+		// keeps them, a full scan would hold every chunk's copy in memory.
+		std::string data_3d;
+		std::string block_entities;
 
 		Chunk() {
-			memset(blocks, 0, sizeof(blocks));
+			chunk_x = 0;
+			chunk_z = 0;
+			chunk_format_version = -1;
+		}
 
+		// Drops everything loaded so far but keeps the coordinates, so one Chunk can be reused across loads
+		void clear() {
 			chunk_format_version = -1;
+
+			for (SubChunk& sub_chunk : sub_chunks)
+				sub_chunk.storages.clear();
+
+			data_3d.clear();
+			block_entities.clear();
 		}
 
+		// nullptr if chunk_y is outside the height range
+		SubChunk* get_sub_chunk(int32_t chunk_y) {
+			if (chunk_y < kMinSubChunk || chunk_y > kMaxSubChunk) return nullptr;
+
+			return &sub_chunks[chunk_y - kMinSubChunk];
+		}
+
+		/**
+			BlockRegistry ID of the block at chunk local x/z (0-15) and world y, decoded straight from the packed
+			storage. Returns kInvalidBlockId when the sub-chunk or layer was never loaded, or when the stored palette
+			index is past the end of the palette.
+		*/
+		uint32_t GetBlock(int32_t x, int32_t y, int32_t z, size_t layer = 0) const;
+
 		int32_t ParseChunk(int32_t chunk_x, int32_t chunk_y, int32_t chunk_z, const char* buffer, size_t buffer_length,
 			int32_t dimension_id, const std::string& dimension_name);
 	};
-} // namespace smokey_bedrock_parser
\ No newline at end of file
+} // namespace smokey_bedrock_parser
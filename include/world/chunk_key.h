@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace smokey_bedrock_parser {
+	// https://learn.microsoft.com/en-us/minecraft/creator/documents/actorstorage
+	enum class ChunkTag : char {
+		Data3D = 43,
+		Version, // This was moved to the front as needed for the extended heights feature. Old chunks will not have this data.
+		Data2D,
+		Data2DLegacy,
+		SubChunkPrefix,
+		LegacyTerrain,
+		BlockEntity,
+		Entity,
+		PendingTicks,
+		LegacyBlockExtraData,
+		BiomeState,
+		FinalizedState,
+		ConversionData, // data that the converter provides, that are used at runtime for things like blending
+		BorderBlocks,
+		HardcodedSpawners,
+		RandomTicks,
+		CheckSums,
+		GenerationSeed,
+		GeneratedPreCavesAndCliffsBlending = 61, // not used, DON'T REMOVE
+		BlendingBiomeHeight = 62, // not used, DON'T REMOVE
+		MetaDataHash,
+		BlendingData,
+		ActorDigestVersion,
+		LegacyVersion = 118,
+	};
+
+	// Dimension ids as stored in chunk keys; overworld keys leave the id out
+	enum class DimensionId : int32_t {
+		Overworld = 0,
+		Nether,
+		TheEnd
+	};
+
+	// Decoded chunk record key. Plain data so decoding never allocates.
+	struct ChunkKey {
+		int32_t chunk_x;
+		int32_t chunk_z;
+		DimensionId dimension;
+		ChunkTag tag;
+		// Only set for SubChunkPrefix records, 0 otherwise
+		int8_t sub_chunk;
+	};
+
+	// first is true when key looks like a chunk record key, second is the raw tag byte
+	std::pair<bool, int32_t> IsChunkKey(std::string_view key);
+
+	/**
+		Decodes [x:int32][z:int32]([dimension:int32])[tag:byte]([sub_chunk:byte]). Returns false, leaving
+		chunk_key untouched, if key is not a chunk record key.
+	*/
+	inline bool DecodeChunkKey(std::string_view key, ChunkKey& chunk_key) {
+		size_t tag_offset;
+
+		switch (key.size()) {
+		case 9:
+		case 10:
+			tag_offset = 8;
+
+			break;
+		case 13:
+		case 14:
+			tag_offset = 12;
+
+			break;
+		default:
+			return false;
+		}
+
+		char tag = key[tag_offset];
+
+		if (!((33 <= tag && tag <= 64) || tag == 118)) return false;
+
+		int32_t dimension = 0;
+
+		if (tag_offset == 12)
+			memcpy(&dimension, key.data() + 8, 4);
+
+		memcpy(&chunk_key.chunk_x, key.data(), 4);
+		memcpy(&chunk_key.chunk_z, key.data() + 4, 4);
+		chunk_key.dimension = DimensionId(dimension);
+		chunk_key.tag = ChunkTag(tag);
+		chunk_key.sub_chunk = key.size() > tag_offset + 1 ? int8_t(key[tag_offset + 1]) : 0;
+
+		return true;
+	}
+
+	/**
+		Writes the [x:int32][z:int32]([dimension:int32]) prefix shared by every record of a chunk and returns its
+		length, 8 for the overworld and 12 otherwise. key must have room for 12 bytes.
+	*/
+	inline size_t EncodeChunkKeyPrefix(DimensionId dimension, int32_t chunk_x, int32_t chunk_z, char* key) {
+		int32_t dimension_id = int32_t(dimension);
+
+		memcpy(key, &chunk_x, 4);
+		memcpy(key + 4, &chunk_z, 4);
+
+		if (dimension == DimensionId::Overworld) return 8;
+
+		memcpy(key + 8, &dimension_id, 4);
+
+		return 12;
+	}
+
+	// "overworld", "nether", "the-end" or "(UNKNOWN)"
+	const char* GetDimensionName(DimensionId dimension);
+} // namespace smokey_bedrock_parser
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "world/chunk.h"
+
+namespace smokey_bedrock_parser {
+	/**
+		Chunk index of a dimension, keyed on the chunk coordinates packed into 64 bits.
+
+		Lookups go through an open-addressing table with linear probing that only stores keys and 32-bit chunk
+		numbers, so a probe touches one or two cache lines. Chunks themselves are allocated kChunkBlockSize at a
+		time and never move, so pointers returned by Find stay valid until the map is cleared.
+
+		With set_store_chunks(false) the map only records which chunks exist, at a few bytes per chunk, and Find
+		and FindOrInsert return nullptr chunks.
+	*/
+	class ChunkMap {
+	public:
+		static constexpr size_t kChunkBlockSize = 256;
+
+		ChunkMap() = default;
+		ChunkMap(const ChunkMap&) = delete;
+		ChunkMap& operator=(const ChunkMap&) = delete;
+
+		static uint64_t PackKey(int32_t chunk_x, int32_t chunk_z) {
+			return (uint64_t(uint32_t(chunk_x)) << 32) | uint32_t(chunk_z);
+		}
+
+		size_t size() const {
+			return chunk_count;
+		}
+
+		// Only takes effect while the map is empty
+		void set_store_chunks(bool store) {
+			if (chunk_count == 0)
+				store_chunks = store;
+		}
+
+		bool get_store_chunks() const {
+			return store_chunks;
+		}
+
+		// nullptr if the chunk has not been added or chunks are not stored
+		Chunk* Find(int32_t chunk_x, int32_t chunk_z);
+
+		// second is true if the chunk was created by this call
+		std::pair<Chunk*, bool> FindOrInsert(int32_t chunk_x, int32_t chunk_z);
+
+		/**
+			Adds every chunk of other that is not already present to this map and clears other. Chunk contents are
+			moved over when both maps store them.
+		*/
+		void Merge(ChunkMap& other);
+
+		void clear();
+
+		// Only visits anything when chunks are stored
+		template <typename Function>
+		void ForEach(Function&& function) {
+			if (!store_chunks) return;
+
+			for (size_t i = 0; i < chunk_count; i++)
+				function(chunk_at(i));
+		}
+
+	private:
+		// 0 marks an empty slot, otherwise the chunk number + 1
+		std::vector<uint64_t> keys;
+		std::vector<uint32_t> slots;
+		std::vector<std::unique_ptr<Chunk[]>> chunk_blocks;
+		size_t chunk_count = 0;
+		bool store_chunks = true;
+
+		Chunk& chunk_at(size_t index) {
+			return chunk_blocks[index / kChunkBlockSize][index % kChunkBlockSize];
+		}
+
+		size_t Probe(uint64_t key) const;
+
+		void Grow();
+	};
+} // namespace smokey_bedrock_parser
@@ -1,15 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <climits>
 #include <cstdint>
-#include <map>
-#include <memory>
 #include <string>
-#include <utility>
 #include <vector>
 
 #include "logger.h"
 #include "world/chunk.h"
+#include "world/chunk_map.h"
 
 namespace smokey_bedrock_parser {
 	const std::vector<std::string> dimension_id_names{ "overworld","nether","the-end" };
@@ -57,22 +56,56 @@ namespace smokey_bedrock_parser {
 			return max_chunk_z;
 		}
 
-		int32_t AddChunk(int32_t chunk_format_version, int32_t chunk_x, int32_t chunk_y, int32_t chunk_z, const char* buffer,
-			size_t buffer_length) {
-			ChunkKey key(chunk_x, chunk_z);
+		size_t get_chunk_count() {
+			return chunks.size();
+		}
+
+		// nullptr if the chunk has not been loaded or the dimension does not keep chunks
+		Chunk* get_chunk(int32_t chunk_x, int32_t chunk_z) {
+			return chunks.Find(chunk_x, chunk_z);
+		}
+
+		/**
+			Whether AddChunk keeps a Chunk, and with it every decoded sub-chunk, for each chunk. On by default;
+			a full world scan turns it off so memory does not grow with the world, and then only the chunk
+			coordinates are recorded. Only takes effect while the dimension is empty.
+		*/
+		void set_keep_chunks(bool keep) {
+			chunks.set_store_chunks(keep);
+		}
+
+		bool get_keep_chunks() const {
+			return chunks.get_store_chunks();
+		}
 
-			if (chunk_format_version == 7) return chunks[key]->ParseChunk(chunk_x, chunk_y, chunk_z, buffer, buffer_length, dimension_id, dimension_name);
-			else {
-				log::error("Unknown chunk format version (version = {})", chunk_format_version);
-				return -1;
+		// Records the chunk and widens the bounds. Returns the chunk to decode into, nullptr if chunks are not kept.
+		Chunk* AddChunk(int32_t chunk_x, int32_t chunk_z) {
+			auto [chunk, inserted] = chunks.FindOrInsert(chunk_x, chunk_z);
+
+			if (inserted) {
+				min_chunk_x = std::min(min_chunk_x, chunk_x);
+				max_chunk_x = std::max(max_chunk_x, chunk_x);
+				min_chunk_z = std::min(min_chunk_z, chunk_z);
+				max_chunk_z = std::max(max_chunk_z, chunk_z);
 			}
-		};
+
+			return chunk;
+		}
+
+		// Moves every chunk from other into this dimension. Used to fold the per-worker results of a parallel scan
+		// back together; record batches never split a chunk so the two maps are disjoint.
+		void Merge(Dimension& other) {
+			chunks.Merge(other.chunks);
+
+			min_chunk_x = std::min(min_chunk_x, other.min_chunk_x);
+			max_chunk_x = std::max(max_chunk_x, other.max_chunk_x);
+			min_chunk_z = std::min(min_chunk_z, other.min_chunk_z);
+			max_chunk_z = std::max(max_chunk_z, other.max_chunk_z);
+		}
 
 	private:
 		std::string dimension_name;
 		int32_t dimension_id;
-		typedef std::pair<uint32_t, uint32_t> ChunkKey;
-		typedef std::map<ChunkKey, std::unique_ptr<Chunk>> ChunkMap;
 		ChunkMap chunks;
 		int32_t min_chunk_x, max_chunk_x;
 		int32_t min_chunk_z, max_chunk_z;
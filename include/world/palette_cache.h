@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "world/block_registry.h"
+
+namespace smokey_bedrock_parser {
+	/**
+		Bounded map from the raw serialized bytes of one palette entry to the block ID it resolved to.
+
+		Most sub-chunks share the same few dozen palette entries, so a hit lets the caller skip decoding the
+		compound and interning it. The table is direct-mapped: a new entry simply replaces whatever hashed to the
+		same slot. Not thread-safe, each scan thread uses its own through ForThread.
+	*/
+	class PaletteCache {
+	public:
+		static constexpr size_t kSlotCount = 4096;
+
+		PaletteCache() : slots(new Slot[kSlotCount]) {}
+
+		static PaletteCache& ForThread();
+
+		// kInvalidBlockId on a miss
+		uint32_t Find(std::string_view entry) {
+			uint64_t hash = Hash(entry);
+			const Slot& slot = slots[hash % kSlotCount];
+
+			if (slot.hash == hash && slot.entry == entry) {
+				hit_count++;
+
+				return slot.id;
+			}
+
+			miss_count++;
+
+			return kInvalidBlockId;
+		}
+
+		void Insert(std::string_view entry, uint32_t id) {
+			uint64_t hash = Hash(entry);
+			Slot& slot = slots[hash % kSlotCount];
+
+			slot.hash = hash;
+			slot.entry.assign(entry.data(), entry.size());
+			slot.id = id;
+		}
+
+		uint64_t get_hit_count() const {
+			return hit_count;
+		}
+
+		uint64_t get_miss_count() const {
+			return miss_count;
+		}
+
+	private:
+		struct Slot {
+			uint64_t hash = 0;
+			std::string entry;
+			uint32_t id = kInvalidBlockId;
+		};
+
+		std::unique_ptr<Slot[]> slots;
+		uint64_t hit_count = 0;
+		uint64_t miss_count = 0;
+
+		static uint64_t Hash(std::string_view entry);
+	};
+} // namespace smokey_bedrock_parser
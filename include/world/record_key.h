@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "world/chunk_key.h"
+
+namespace smokey_bedrock_parser {
+	// What a LevelDB record holds, judged by its key alone
+	enum class RecordKind : uint8_t {
+		Unknown,
+		Chunk,
+		// Named singletons such as BiomeData, Overworld or scoreboard
+		Global,
+		LocalPlayer,
+		// player_<id> and player_server_<id>
+		Player,
+		// map_<id>
+		Map,
+		// actorprefix<id:int64>
+		Actor,
+		// digp<chunk prefix>, the actor IDs that live in one chunk
+		ActorDigest,
+		VillageInfo,
+		VillagePlayers,
+		VillageDwellers,
+		VillagePoi
+	};
+
+	constexpr size_t kRecordKindCount = size_t(RecordKind::VillagePoi) + 1;
+
+	// Short lower-case name, e.g. "chunk" or "village-info"
+	const char* GetRecordKindName(RecordKind kind);
+
+	/**
+		A classified key. Views point into the key that was classified and are only valid as long as it is.
+	*/
+	struct RecordKey {
+		RecordKind kind = RecordKind::Unknown;
+		// Set for Chunk
+		ChunkKey chunk;
+		/**
+			Global: the key itself. Player and Map: the id after the prefix. Village kinds: everything between
+			"VILLAGE_" and the final "_INFO", "_POI", ... i.e. "<dimension>_<uuid>" or just "<uuid>" on old worlds.
+		*/
+		std::string_view name;
+	};
+
+	// One pass over the key, never allocates
+	RecordKey ClassifyRecordKey(std::string_view key);
+} // namespace smokey_bedrock_parser
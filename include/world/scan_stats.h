@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "json.hpp"
+#include "world/record_key.h"
+
+namespace smokey_bedrock_parser {
+	/**
+		Distribution of non-negative values in power-of-two buckets: bucket 0 counts zeros and bucket i the values
+		in [2^(i-1), 2^i). Percentiles are therefore only accurate to within a factor of two, which is plenty for
+		telling a 40 byte record from a 40 KB one.
+	*/
+	struct Histogram {
+		static constexpr size_t kBucketCount = 48;
+
+		std::array<uint64_t, kBucketCount> buckets{};
+		uint64_t count = 0;
+		uint64_t sum = 0;
+		uint64_t min = UINT64_MAX;
+		uint64_t max = 0;
+
+		void Add(uint64_t value) {
+			size_t bucket = 0;
+
+			while (bucket + 1 < kBucketCount && value >= (uint64_t(1) << bucket))
+				bucket++;
+
+			buckets[bucket]++;
+			count++;
+			sum += value;
+			min = value < min ? value : min;
+			max = value > max ? value : max;
+		}
+
+		void Merge(const Histogram& other);
+
+		// Upper bound of the bucket holding the given fraction (0-1) of all values, clamped to max
+		uint64_t Percentile(double fraction) const;
+
+		nlohmann::json ToJson() const;
+	};
+
+	// Number of calls and time spent in one stage
+	struct StageTime {
+		uint64_t count = 0;
+		uint64_t nanoseconds = 0;
+
+		void Add(uint64_t elapsed_nanoseconds) {
+			count++;
+			nanoseconds += elapsed_nanoseconds;
+		}
+
+		void Merge(const StageTime& other) {
+			count += other.count;
+			nanoseconds += other.nanoseconds;
+		}
+
+		double seconds() const {
+			return nanoseconds / 1e9;
+		}
+
+		nlohmann::json ToJson() const;
+	};
+
+	/**
+		What a ParseDB pass read and where it spent its time. Every decode worker fills its own copy without any
+		synchronization and the copies are merged once the scan is done, like the chunks themselves.
+	*/
+	struct ScanStats {
+		// Bedrock stores block storages with 0 (single entry palette) to 16 bits per block
+		static constexpr size_t kMaxBitsPerBlock = 16;
+
+		std::array<uint64_t, kRecordKindCount> records_by_kind{};
+		// Key plus value bytes, i.e. after LevelDB has decompressed the blocks
+		std::array<uint64_t, kRecordKindCount> bytes_by_kind{};
+		Histogram value_sizes;
+		// Approximate on-disk (compressed) size of everything the scan iterated over
+		uint64_t bytes_read = 0;
+
+		StageTime nbt_decode;
+		std::array<StageTime, kMaxBitsPerBlock + 1> sub_chunk_decode_by_bits;
+		uint64_t sub_chunk_errors = 0;
+		Histogram palette_sizes;
+		uint64_t palette_cache_hits = 0;
+		uint64_t palette_cache_misses = 0;
+
+		// Wall clock of each ParseDB phase
+		StageTime count_phase;
+		StageTime scan_phase;
+		StageTime actor_phase;
+		StageTime village_phase;
+
+		// LevelDB's own view, sampled once the scan is done
+		size_t block_cache_capacity = 0;
+		size_t block_cache_usage = 0;
+		uint64_t approximate_memory_usage = 0;
+		std::string leveldb_stats;
+
+		uint64_t record_count() const;
+
+		uint64_t bytes_decompressed() const;
+
+		void Merge(const ScanStats& other);
+
+		nlohmann::json ToJson() const;
+
+		// Writes the interesting parts to the info log
+		void LogSummary() const;
+	};
+} // namespace smokey_bedrock_parser
@@ -1,10 +1,23 @@
 #pragma once
 
 #include <cstdio>
+#include <functional>
+#include <leveldb/cache.h>
+#include <leveldb/compressor.h>
 #include <leveldb/db.h>
+#include <leveldb/decompress_allocator.h>
+#include <leveldb/env.h>
+#include <leveldb/filter_policy.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include "logger.h"
+#include "nbt.h"
+#include "world/chunk_key.h"
 #include "world/dimension.h"
+#include "world/scan_stats.h"
 
 
 namespace smokey_bedrock_parser {
@@ -66,6 +79,26 @@ namespace smokey_bedrock_parser {
 		int32_t world_spawn_z;
 	};
 
+	// LevelDB tuning, applied by the next OpenDB
+	struct LevelDBConfig {
+		// Shared LRU cache of uncompressed SST blocks, in bytes
+		size_t block_cache_size = 40 * 1024 * 1024;
+		int32_t bloom_filter_bits_per_key = 10;
+		size_t write_buffer_size = 4 * 1024 * 1024;
+		// Whether the full-world passes of ParseDB and CalculateTotalRecords add the blocks they read to the cache.
+		// They read every block exactly once, so by default they leave the cache to LoadChunk and ScanRegion.
+		bool fill_cache_on_scan = false;
+		bool verify_checksums = false;
+		// Hand decompression buffers back for the next block read instead of allocating one per block
+		bool reuse_decompress_buffers = true;
+		/**
+			For worlds a running server is still writing to. OpenDB opens a private copy of the db directory, with
+			the immutable table files hardlinked and only the manifest and logs copied, so the server's lock is
+			never taken, and every read then goes through one snapshot of that copy.
+		*/
+		bool read_only = false;
+	};
+
 	class MinecraftWorldLevelDB : public MinecraftWorld {
 	public:
 		std::vector<std::unique_ptr<Dimension>> dimensions;
@@ -80,19 +113,26 @@ namespace smokey_bedrock_parser {
 
 		int32_t OpenDB(std::string db_directory);
 
-		int32_t CloseDB() {
-			if (db != nullptr) {
-				delete db;
-				db = nullptr;
-			}
+		int32_t CloseDB();
 
-			return 0;
+		// Only takes effect on the next OpenDB
+		void set_db_config(const LevelDBConfig& config) {
+			db_config = config;
+		}
+
+		const LevelDBConfig& get_db_config() {
+			return db_config;
 		}
 
 		int32_t CalculateTotalRecords();
 
 		int32_t ParseLevelFile(std::string file_name);
 
+		// The decoded level.dat, kept for display
+		const NbtTagList& get_level_tags() {
+			return level_tags;
+		}
+
 		int32_t ParseLevelName(std::string file_name) {
 			FILE* file = fopen(file_name.c_str(), "r");
 
@@ -117,12 +157,156 @@ namespace smokey_bedrock_parser {
 			return 0;
 		}
 
+		// Count every record up front for an exact progress percentage. This reads the whole world twice, so by
+		// default progress is estimated from LevelDB's approximate on-disk sizes instead.
+		void set_exact_record_count(bool exact) {
+			exact_record_count = exact;
+		}
+
+		bool get_exact_record_count() {
+			return exact_record_count;
+		}
+
+		// Chunk records of disabled dimensions are skipped during ParseDB. All dimensions are enabled by default.
+		void set_dimension_enabled(int32_t dimension_id, bool enabled) {
+			if (dimension_id >= 0 && dimension_id < (int32_t)enabled_dimensions.size())
+				enabled_dimensions[dimension_id] = enabled;
+		}
+
+		bool is_dimension_enabled(int32_t dimension_id) {
+			return dimension_id >= 0 && dimension_id < (int32_t)enabled_dimensions.size() && enabled_dimensions[dimension_id];
+		}
+
+		/**
+			Whether ParseDB keeps the decoded sub-chunks of every chunk in dimensions. Off by default, since that
+			holds every block of the world in memory; a full scan then only records which chunks exist. Use
+			LoadChunk or ScanRegion for the blocks of part of the world. Set before the first ParseDB.
+		*/
+		void set_keep_chunks(bool keep) {
+			keep_chunks = keep;
+		}
+
+		bool get_keep_chunks() {
+			return keep_chunks;
+		}
+
+		// Records read by the last ParseDB
+		int32_t get_parsed_record_count() {
+			return parsed_record_count;
+		}
+
+		// Counters and timings of the last ParseDB
+		const ScanStats& get_scan_stats() {
+			return scan_stats;
+		}
+
+		// Decode workers used by ParseDB, 0 uses every core
+		void set_thread_count(int32_t count) {
+			thread_count = count;
+		}
+
+		int32_t get_thread_count() {
+			return thread_count;
+		}
+
+		// Threads iterating LevelDB (and decompressing its blocks) for ParseDB, 0 picks one per four workers
+		void set_io_thread_count(int32_t count) {
+			io_thread_count = count;
+		}
+
+		int32_t get_io_thread_count() {
+			return io_thread_count;
+		}
+
 		int32_t ParseDB();
 
+		/**
+			Replaces the contents of chunk with every record of one chunk (version, Data3D, sub-chunks and block
+			entities), read with a single seek and without touching the rest of the world. Safe to call from several threads at once; each
+			thread keeps reusing its own iterator. Returns the number of records read, 0 if the chunk does not
+			exist, or -1 on a LevelDB error.
+		*/
+		int32_t LoadChunk(DimensionId dimension, int32_t chunk_x, int32_t chunk_z, Chunk& chunk);
+
+		/**
+			Loads every existing chunk with min_x <= x <= max_x and min_z <= z <= max_z and hands each one to
+			callback. The chunk passed in is reused for the next call, so copy out what needs to outlive it. The
+			region is read with an iterator of its own, so callback is free to LoadChunk neighbouring chunks.
+
+			Chunks are visited in LevelDB key order rather than by coordinate, so the iterator only ever moves
+			forward and neighbouring chunks come out of the same, already cached, SST blocks. Returns the number of
+			chunks visited or -1 on a LevelDB error.
+		*/
+		int32_t ScanRegion(DimensionId dimension, int32_t min_x, int32_t min_z, int32_t max_x, int32_t max_z,
+			const std::function<void(const Chunk& chunk)>& callback);
+
 	private:
+		struct KeyRange;
+		struct ScanResult;
+		struct ScanProgress;
+		struct RecordBatch;
+		struct BatchQueue;
+
 		leveldb::DB* db;
+		LevelDBConfig db_config;
+		// Everything Options points at has to outlive the DB
 		std::unique_ptr<leveldb::Options> db_options;
+		std::unique_ptr<leveldb::Cache> block_cache;
+		std::unique_ptr<const leveldb::FilterPolicy> filter_policy;
+		std::unique_ptr<leveldb::Logger> info_log;
+		std::unique_ptr<leveldb::Compressor> zlib_raw_compressor;
+		std::unique_ptr<leveldb::Compressor> zlib_compressor;
+		std::unique_ptr<leveldb::DecompressAllocator> decompress_allocator;
+		// Set in read-only mode
+		const leveldb::Snapshot* snapshot;
+		std::string snapshot_directory;
+		NbtTagList level_tags;
 		int32_t total_record_count;
+		int32_t parsed_record_count;
+		uint64_t total_approximate_size;
+		bool exact_record_count;
+		bool keep_chunks;
+		int32_t thread_count;
+		int32_t io_thread_count;
+		std::vector<bool> enabled_dimensions;
+		ScanStats scan_stats;
+		std::mutex iterator_mutex;
+		std::unordered_map<std::thread::id, std::unique_ptr<leveldb::Iterator>> thread_iterators;
+
+		uint64_t ApproximateSize(const std::string& start, const std::string& limit);
+
+		std::vector<KeyRange> SplitKeyRanges(int32_t range_count);
+
+		// Iterates one key range and hands its records to the decode workers in batches
+		int32_t ScanKeyRange(size_t range_index, const KeyRange& range, BatchQueue& queue, ScanProgress& progress);
+
+		// Decode worker loop, runs until every ScanKeyRange has finished and the queue is drained
+		void DecodeBatches(BatchQueue& queue, ScanResult& result);
+
+		int32_t ParseRecord(const leveldb::Slice& key, const leveldb::Slice& value, ScanResult& result);
+
+		/**
+			Reads and decodes the actorprefix record of every actor listed in the scanned digp records. The keys
+			are walked in sorted order with one iterator, which turns a point lookup per actor into mostly Next
+			calls over neighbouring blocks, and decoding is spread over worker_count threads. Returns the number
+			of actors found or -1 on a LevelDB error.
+		*/
+		int32_t LoadActors(const std::vector<uint64_t>& actor_ids, int32_t worker_count);
+
+		// Looks up the players, dwellers and POI records of every village found by the scan
+		void AssembleVillages(const std::vector<std::string>& villages);
+
+		// Copies db_directory/db into a fresh directory inside db_directory and returns its path, empty on failure
+		std::string CopyDBForReading(const std::string& db_directory);
+
+		// bulk_scan is for passes over the whole world, everything else is treated as random access
+		leveldb::ReadOptions GetReadOptions(bool bulk_scan);
+
+		// The calling thread's iterator, created on first use
+		leveldb::Iterator* GetThreadIterator();
+
+		// Reads records from the current position of it as long as they start with prefix
+		int32_t ReadChunkRecords(leveldb::Iterator* it, const leveldb::Slice& prefix, DimensionId dimension, Chunk& chunk);
 	};
 
 	extern std::unique_ptr<MinecraftWorldLevelDB> world;
@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <string>
 
+#include "gui/nbt_view.h"
 #include "world/world.h"
 
 static void GLFWErrorCallback(int error, const char* description) {
@@ -27,7 +28,11 @@ int main(int argc, char** argv) {
 	auto file_log_level = Level::Trace;
 	std::filesystem::path log_directory = "logs/debug.log";
 
-	SetupLoggerStage2(log_directory, console_log_level, file_log_level);
+	// The file sink takes every trace message, keep its I/O off the UI and scan threads
+	AsyncLogOptions async_log;
+	async_log.enabled = true;
+
+	SetupLoggerStage2(log_directory, console_log_level, file_log_level, async_log);
 
 	world = std::make_unique<MinecraftWorldLevelDB>();
 
@@ -58,8 +63,11 @@ int main(int argc, char** argv) {
 
 	glfwSetErrorCallback(GLFWErrorCallback);
 
-	if (!glfwInit())
+	if (!glfwInit()) {
+		ShutdownLogger();
+
 		return 1;
+	}
 
 #if defined(IMGUI_IMPL_OPENGL_ES2)
 	// GL ES 2.0 + GLSL 100
@@ -85,8 +93,11 @@ int main(int argc, char** argv) {
 
 	GLFWwindow* window = glfwCreateWindow(1080, 720, "SmokeyBedrockParser", nullptr, nullptr);
 
-	if (window == nullptr)
+	if (window == nullptr) {
+		ShutdownLogger();
+
 		return 1;
+	}
 
 	glfwMakeContextCurrent(window);
 
@@ -235,6 +246,7 @@ int main(int argc, char** argv) {
 
 			ImGui::Columns(2, "nbt_view");
 			world->init(argv[1]);
+			RenderNbt(world->get_level_tags());
 			world->OpenDB(argv[1]);
 			ImGui::Columns(1);
 
@@ -263,5 +275,7 @@ int main(int argc, char** argv) {
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
+	ShutdownLogger();
+
 	return 0;
 }
\ No newline at end of file
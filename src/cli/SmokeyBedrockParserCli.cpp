@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "trace.h"
+#include "world/world.h"
+
+namespace {
+	using namespace smokey_bedrock_parser;
+
+	struct CliOptions {
+		std::string world_directory;
+		std::string output_format = "text";
+		std::string output_file;
+		std::filesystem::path trace_file;
+		std::filesystem::path log_file = "logs/cli.log";
+		Level console_log_level = Level::Warn;
+		Level file_log_level = Level::Info;
+		AsyncLogOptions async_log;
+		int32_t thread_count = 0;
+		int32_t io_thread_count = 0;
+		std::vector<std::string> dimensions;
+		bool exact_record_count = false;
+		LevelDBConfig db_config;
+	};
+
+	void PrintUsage(const char* program) {
+		fprintf(stderr,
+			"Usage: %s <world directory> [options]\n"
+			"\n"
+			"Options:\n"
+			"  --threads <n>          Decode threads, 0 uses every core (default: 0)\n"
+			"  --io-threads <n>       LevelDB reader threads, 0 uses one per four decode threads (default: 0)\n"
+			"  --dimensions <list>    Comma separated list of overworld,nether,the-end (default: all)\n"
+			"  --format <text|json>   Summary format (default: text)\n"
+			"  --output <file>        Write the summary to a file instead of stdout\n"
+			"  --log <file>           Log file (default: logs/cli.log)\n"
+			"  --log-level <level>    Console log level: trace, debug, info, warn, error (default: warn)\n"
+			"  --file-log-level <lvl> File log level (default: info)\n"
+			"  --async-log            Write log messages from a background thread\n"
+			"  --log-queue <n>        Async log queue size in messages (default: 8192)\n"
+			"  --log-overflow <mode>  When the async queue is full: block or drop-oldest (default: block)\n"
+			"  --exact-count          Count every record before scanning for exact progress\n"
+			"  --cache-mb <n>         LevelDB block cache size in MB (default: 40)\n"
+			"  --fill-cache           Let full scans populate the block cache\n"
+			"  --verify-checksums     Verify the checksum of every block read\n"
+			"  --read-only            Scan a copy of a world a server is still running\n"
+			"  --trace <file>         Write a Chrome trace-event timeline of the scan (open in ui.perfetto.dev)\n"
+			"  --help                 Show this message\n",
+			program);
+	}
+
+	bool ParseLevel(const std::string& name, Level& level) {
+		if (name == "trace") level = Level::Trace;
+		else if (name == "debug") level = Level::Debug;
+		else if (name == "info") level = Level::Info;
+		else if (name == "warn") level = Level::Warn;
+		else if (name == "error") level = Level::Error;
+		else return false;
+
+		return true;
+	}
+
+	std::vector<std::string> SplitList(const std::string& list) {
+		std::vector<std::string> items;
+		size_t start = 0;
+
+		while (start <= list.size()) {
+			size_t end = list.find(',', start);
+
+			if (end == std::string::npos)
+				end = list.size();
+
+			if (end > start)
+				items.push_back(list.substr(start, end - start));
+
+			start = end + 1;
+		}
+
+		return items;
+	}
+
+	int32_t ParseArguments(int argc, char** argv, CliOptions& options) {
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			bool has_value = i + 1 < argc;
+
+			if (argument == "--help" || argument == "-h") {
+				return 1;
+			}
+			else if (argument == "--threads" && has_value) {
+				options.thread_count = atoi(argv[++i]);
+			}
+			else if (argument == "--io-threads" && has_value) {
+				options.io_thread_count = atoi(argv[++i]);
+			}
+			else if (argument == "--dimensions" && has_value) {
+				options.dimensions = SplitList(argv[++i]);
+			}
+			else if (argument == "--format" && has_value) {
+				options.output_format = argv[++i];
+
+				if (options.output_format != "text" && options.output_format != "json") {
+					fprintf(stderr, "Unknown output format '%s'\n", options.output_format.c_str());
+					return -1;
+				}
+			}
+			else if (argument == "--output" && has_value) {
+				options.output_file = argv[++i];
+			}
+			else if (argument == "--log" && has_value) {
+				options.log_file = argv[++i];
+			}
+			else if (argument == "--log-level" && has_value) {
+				if (!ParseLevel(argv[++i], options.console_log_level)) {
+					fprintf(stderr, "Unknown log level '%s'\n", argv[i]);
+					return -1;
+				}
+			}
+			else if (argument == "--file-log-level" && has_value) {
+				if (!ParseLevel(argv[++i], options.file_log_level)) {
+					fprintf(stderr, "Unknown log level '%s'\n", argv[i]);
+					return -1;
+				}
+			}
+			else if (argument == "--async-log") {
+				options.async_log.enabled = true;
+			}
+			else if (argument == "--log-queue" && has_value) {
+				options.async_log.queue_size = size_t(std::max(1, atoi(argv[++i])));
+			}
+			else if (argument == "--log-overflow" && has_value) {
+				std::string mode = argv[++i];
+
+				if (mode == "block")
+					options.async_log.block_when_full = true;
+				else if (mode == "drop-oldest")
+					options.async_log.block_when_full = false;
+				else {
+					fprintf(stderr, "Unknown log overflow mode '%s'\n", mode.c_str());
+					return -1;
+				}
+			}
+			else if (argument == "--exact-count") {
+				options.exact_record_count = true;
+			}
+			else if (argument == "--cache-mb" && has_value) {
+				options.db_config.block_cache_size = size_t(std::max(0, atoi(argv[++i]))) * 1024 * 1024;
+			}
+			else if (argument == "--fill-cache") {
+				options.db_config.fill_cache_on_scan = true;
+			}
+			else if (argument == "--verify-checksums") {
+				options.db_config.verify_checksums = true;
+			}
+			else if (argument == "--read-only") {
+				options.db_config.read_only = true;
+			}
+			else if (argument == "--trace" && has_value) {
+				options.trace_file = argv[++i];
+			}
+			else if (argument.rfind("--", 0) != 0 && options.world_directory.empty()) {
+				options.world_directory = argument;
+			}
+			else {
+				fprintf(stderr, "Unknown or incomplete option '%s'\n", argument.c_str());
+				return -1;
+			}
+		}
+
+		if (options.world_directory.empty()) {
+			fprintf(stderr, "No world directory given\n");
+			return -1;
+		}
+
+		return 0;
+	}
+
+	nlohmann::json BuildSummary(MinecraftWorldLevelDB& level_db, double elapsed_seconds) {
+		nlohmann::json summary;
+
+		summary["world"] = {
+			{ "name", level_db.get_world_name() },
+			{ "seed", level_db.get_world_seed() },
+			{ "spawn", { level_db.get_world_spawn_x(), level_db.get_world_spawn_y(), level_db.get_world_spawn_z() } }
+		};
+		summary["records"] = level_db.get_parsed_record_count();
+		summary["elapsed_seconds"] = elapsed_seconds;
+		summary["dimensions"] = nlohmann::json::array();
+
+		for (auto& dimension : level_db.dimensions) {
+			if (!level_db.is_dimension_enabled(dimension->get_dimension_id()))
+				continue;
+
+			nlohmann::json entry = {
+				{ "id", dimension->get_dimension_id() },
+				{ "name", dimension->get_dimension_name() },
+				{ "chunks", dimension->get_chunk_count() }
+			};
+
+			if (dimension->get_chunk_count() > 0)
+				entry["bounds"] = {
+					{ "min_chunk_x", dimension->get_min_chunk_x() },
+					{ "max_chunk_x", dimension->get_max_chunk_x() },
+					{ "min_chunk_z", dimension->get_min_chunk_z() },
+					{ "max_chunk_z", dimension->get_max_chunk_z() }
+				};
+
+			summary["dimensions"].push_back(entry);
+		}
+
+		summary["stats"] = level_db.get_scan_stats().ToJson();
+
+		return summary;
+	}
+
+	void WriteTextSummary(FILE* out, const nlohmann::json& summary) {
+		fprintf(out, "World: %s\n", summary["world"]["name"].get<std::string>().c_str());
+		fprintf(out, "Seed: %lld\n", (long long)summary["world"]["seed"].get<int64_t>());
+		fprintf(out, "Records: %d\n", summary["records"].get<int32_t>());
+		fprintf(out, "Elapsed: %.2f s\n", summary["elapsed_seconds"].get<double>());
+
+		for (const auto& dimension : summary["dimensions"]) {
+			fprintf(out, "%s: %llu chunks", dimension["name"].get<std::string>().c_str(),
+				(unsigned long long)dimension["chunks"].get<uint64_t>());
+
+			if (dimension.contains("bounds")) {
+				const auto& bounds = dimension["bounds"];
+
+				fprintf(out, " (x %d..%d, z %d..%d)", bounds["min_chunk_x"].get<int32_t>(), bounds["max_chunk_x"].get<int32_t>(),
+					bounds["min_chunk_z"].get<int32_t>(), bounds["max_chunk_z"].get<int32_t>());
+			}
+
+			fprintf(out, "\n");
+		}
+
+		const auto& stats = summary["stats"];
+		const auto& phases = stats["phases"];
+		const double mb = 1024.0 * 1024.0;
+
+		fprintf(out, "Read: %.1f MB on disk, %.1f MB decompressed\n", stats["bytes_read"].get<uint64_t>() / mb,
+			stats["bytes_decompressed"].get<uint64_t>() / mb);
+		fprintf(out, "Phases: count %.2f s, scan %.2f s, actors %.2f s, villages %.2f s\n",
+			phases["count_records"]["seconds"].get<double>(), phases["scan"]["seconds"].get<double>(),
+			phases["actors"]["seconds"].get<double>(), phases["villages"]["seconds"].get<double>());
+		fprintf(out, "Palette cache hit rate: %.1f%%\n", stats["palette_cache"]["hit_rate"].get<double>() * 100.0);
+	}
+
+	struct LoggerShutdownGuard {
+		~LoggerShutdownGuard() {
+			ShutdownLogger();
+		}
+	};
+} // namespace
+
+int main(int argc, char** argv) {
+	using namespace smokey_bedrock_parser;
+
+	CliOptions options;
+	int32_t result = ParseArguments(argc, argv, options);
+
+	if (result != 0) {
+		PrintUsage(argv[0]);
+
+		return result > 0 ? 0 : 2;
+	}
+
+	SetupLoggerStage1();
+	SetupLoggerStage2(options.log_file, options.console_log_level, options.file_log_level, options.async_log);
+
+	// Queued async messages are only written if the logger is shut down before exit, on every return path
+	LoggerShutdownGuard logger_guard;
+
+	world = std::make_unique<MinecraftWorldLevelDB>();
+	world->set_thread_count(options.thread_count);
+	world->set_io_thread_count(options.io_thread_count);
+	world->set_exact_record_count(options.exact_record_count);
+	world->set_db_config(options.db_config);
+
+	if (!options.dimensions.empty()) {
+		for (size_t i = 0; i < dimension_id_names.size(); i++)
+			world->set_dimension_enabled((int32_t)i, false);
+
+		for (const auto& name : options.dimensions) {
+			auto found = std::find(dimension_id_names.begin(), dimension_id_names.end(), name);
+
+			if (found == dimension_id_names.end()) {
+				log::error("Unknown dimension '{}'", name);
+
+				return 2;
+			}
+
+			world->set_dimension_enabled((int32_t)(found - dimension_id_names.begin()), true);
+		}
+	}
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	if (!options.trace_file.empty()) {
+		trace::Start();
+		trace::SetThreadName("main");
+	}
+
+	if (world->init(options.world_directory) != 0)
+		return 1;
+
+	// Still write the trace when the open fails, that is often what it is for
+	bool opened = world->OpenDB(options.world_directory) == 0;
+
+	if (opened)
+		result = world->ParseDB();
+
+	world->CloseDB();
+
+	if (!options.trace_file.empty())
+		trace::Stop(options.trace_file);
+
+	if (!opened)
+		return 1;
+
+	double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	nlohmann::json summary = BuildSummary(*world, elapsed_seconds);
+	FILE* out = stdout;
+
+	if (!options.output_file.empty()) {
+		out = fopen(options.output_file.c_str(), "w");
+
+		if (!out) {
+			log::error("Failed to open output file (file name={} | error={} ({}))", options.output_file, strerror(errno), errno);
+
+			return 1;
+		}
+	}
+
+	if (options.output_format == "json")
+		fprintf(out, "%s\n", summary.dump(4).c_str());
+	else
+		WriteTextSummary(out, summary);
+
+	if (out != stdout)
+		fclose(out);
+
+	log::info("Done.");
+
+	return result == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "gui/nbt_view.h"
+
+#include <imgui/imgui.h>
+
+namespace {
+	using namespace smokey_bedrock_parser;
+
+	bool renderKey(const std::string& name, const char* type, bool arr) {
+		float px = ImGui::GetCursorPosX() + 18.0f;
+		static const char spaces[51] = {
+			"                                                 \0"
+		};
+		const char* spcptr = &(
+			spaces[50 - int(32.0f / (ImGui::CalcTextSize(" ").x))]
+			);
+		bool open = false;
+		bool show_tooltip = false;
+		if (arr) {
+			open = ImGui::TreeNodeEx(name.c_str(), 0, "%s%s", spcptr, name.c_str());
+		}
+		else {
+			open = ImGui::TreeNodeEx(name.c_str(), ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen, "%s%s", spcptr, name.c_str());
+		}
+		ImGui::SameLine(px);
+		show_tooltip = ImGui::IsItemHovered();
+		if (show_tooltip) {
+			ImGui::BeginTooltip();
+			ImGui::Text("%s", name.c_str());
+			ImGui::SameLine();
+			ImGui::TextDisabled("%s", type);
+			ImGui::EndTooltip();
+		}
+		return open;
+	}
+
+	const char* TypeName(nbt::tag_type type) {
+		switch (type) {
+		case nbt::tag_type::Byte:
+			return "byte";
+		case nbt::tag_type::Short:
+			return "short";
+		case nbt::tag_type::Int:
+			return "int";
+		case nbt::tag_type::Long:
+			return "long";
+		case nbt::tag_type::Float:
+			return "float";
+		case nbt::tag_type::Double:
+			return "double";
+		case nbt::tag_type::Byte_Array:
+			return "byte array";
+		case nbt::tag_type::String:
+			return "string";
+		case nbt::tag_type::List:
+			return "list";
+		case nbt::tag_type::Compound:
+			return "compound";
+		case nbt::tag_type::Int_Array:
+			return "int array";
+		case nbt::tag_type::Long_Array:
+			return "long array";
+		default:
+			return "unknown";
+		}
+	}
+
+	class NbtImGuiVisitor : public NbtVisitor {
+	public:
+		void Value(const std::string& name, const nbt::tag& tag) override {
+			renderKey(name, TypeName(tag.get_type()), false);
+			ImGui::NextColumn();
+			ImGui::PushID(name.c_str());
+			ImGui::Text("%s", NbtValueToJson(tag).dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore).c_str());
+			ImGui::PopID();
+			ImGui::NextColumn();
+		}
+
+		bool BeginContainer(const std::string& name, const nbt::tag& tag) override {
+			bool need_open = renderKey(name, TypeName(tag.get_type()), true);
+			ImGui::NextColumn();
+			ImGui::PushID(name.c_str());
+			ImGui::Text("entries");
+			ImGui::PopID();
+			ImGui::NextColumn();
+
+			return need_open;
+		}
+
+		void EndContainer(const std::string&, const nbt::tag&) override {
+			ImGui::TreePop();
+		}
+	};
+} // namespace
+
+namespace smokey_bedrock_parser {
+	void RenderNbt(const NbtTagList& tag_list) {
+		NbtImGuiVisitor visitor;
+
+		VisitNbt(tag_list, visitor);
+	}
+} // namespace smokey_bedrock_parser
@@ -1,5 +1,6 @@
 #include "logger.h"
 
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
@@ -14,7 +15,8 @@ namespace smokey_bedrock_parser {
 		spdlog::set_default_logger(std::make_shared<spdlog::logger>("stage_1", CreateConsoleSink()));
 	}
 
-	void SetupLoggerStage2(const std::filesystem::path& outpath, Level consoleLevel, Level fileLevel) {
+	void SetupLoggerStage2(const std::filesystem::path& outpath, Level consoleLevel, Level fileLevel,
+		const AsyncLogOptions& async_options) {
 		auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(outpath.generic_string());
 		file_sink->set_level(spdlog::level::level_enum(fileLevel));
 		file_sink->set_pattern("[%Y-%m-%d %T.%e][%=7l] %v");
@@ -23,7 +25,23 @@ namespace smokey_bedrock_parser {
 
 		console_sink->set_level(spdlog::level::level_enum(consoleLevel));
 		spdlog::sinks_init_list sink_list = { file_sink, console_sink };
-		spdlog::set_default_logger(std::make_shared<spdlog::logger>("stage_2", sink_list));
+
+		if (async_options.enabled) {
+			spdlog::init_thread_pool(async_options.queue_size, 1);
+
+			auto overflow_policy = async_options.block_when_full ? spdlog::async_overflow_policy::block
+				: spdlog::async_overflow_policy::overrun_oldest;
+
+			spdlog::set_default_logger(std::make_shared<spdlog::async_logger>("stage_2", sink_list, spdlog::thread_pool(),
+				overflow_policy));
+		}
+		else
+			spdlog::set_default_logger(std::make_shared<spdlog::logger>("stage_2", sink_list));
+
 		spdlog::set_level(spdlog::level::level_enum(consoleLevel > fileLevel ? fileLevel : consoleLevel));
 	}
+
+	void ShutdownLogger() {
+		spdlog::shutdown();
+	}
 } // namespace smokey_bedrock_parser
\ No newline at end of file
@@ -1,223 +1,129 @@
-#include <imgui/imgui.h>
 #include <tuple>
 
 #include "json.hpp"
 #include "logger.h"
 #include "nbt.h"
 
-std::string makeIndent(int32_t indent, const char* hdr) {
-	std::string s;
-	s.append(hdr);
-	for (int32_t i = 0; i < indent; i++) {
-		s.append("  ");
-	}
-	return s;
-}
+namespace {
+	using namespace smokey_bedrock_parser;
 
-bool renderKey(const std::string& name, const char* type, bool arr) {
-	float px = ImGui::GetCursorPosX() + 18.0f;
-	static const char spaces[51] = {
-		"                                                 \0"
-	};
-	const char* spcptr = &(
-		spaces[50 - int(32.0f / (ImGui::CalcTextSize(" ").x))]
-		);
-	bool open = false;
-	bool show_tooltip = false;
-	if (arr) {
-		open = ImGui::TreeNodeEx(name.c_str(), 0, "%s%s", spcptr, name.c_str());
-	}
-	else {
-		open = ImGui::TreeNodeEx(name.c_str(), ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen, "%s%s", spcptr, name.c_str());
-	}
-	ImGui::SameLine(px);
-	show_tooltip = ImGui::IsItemHovered();
-	if (show_tooltip) {
-		ImGui::BeginTooltip();
-		ImGui::Text(name.c_str());
-		ImGui::SameLine();
-		ImGui::TextDisabled("%s", type);
-		ImGui::EndTooltip();
+	std::string makeIndent(int32_t indent, const char* hdr) {
+		std::string s;
+		s.append(hdr);
+		for (int32_t i = 0; i < indent; i++) {
+			s.append("  ");
+		}
+		return s;
 	}
-	return open;
-}
 
-namespace smokey_bedrock_parser {
-	int32_t global_nbt_list_number = 0;
-	int32_t global_nbt_compound_number = 0;
-
-	nlohmann::json::object_t ParseNbtTag(const char* header, int& indent, const NbtTag& tag) {
-		log::trace("{}NBT Tag: {}", makeIndent(indent, header), tag.first);
+	void VisitTag(const std::string& name, const nbt::tag& tag, NbtVisitor& visitor) {
+		static const std::string list_element_name;
 
-		nlohmann::json::object_t json;
+		switch (tag.get_type()) {
+		case nbt::tag_type::List:
+			if (visitor.BeginContainer(name, tag)) {
+				for (const auto& value : tag.as<nbt::tag_list>())
+					VisitTag(list_element_name, value.get(), visitor);
 
-		nbt::tag_type nbt_type = tag.second->get_type();
+				visitor.EndContainer(name, tag);
+			}
+			break;
+		case nbt::tag_type::Compound:
+			if (visitor.BeginContainer(name, tag)) {
+				for (const auto& child : tag.as<nbt::tag_compound>())
+					VisitTag(child.first, child.second.get(), visitor);
 
-		switch (nbt_type) {
-		case nbt::tag_type::End:
-			log::trace("TAG_END");
+				visitor.EndContainer(name, tag);
+			}
+			break;
+		default:
+			visitor.Value(name, tag);
 			break;
-		case nbt::tag_type::Byte: {
-			nbt::tag_byte value = tag.second->as<nbt::tag_byte>();
-			log::trace("TAG_BYTE: {}", value.get());
-			json[tag.first] = value.get();
-
-			renderKey(tag.first, "byte", false);
-			ImGui::NextColumn();
-			ImGui::PushID(tag.first.c_str());
-			ImGui::Text(json[tag.first].dump().c_str());
-			ImGui::PopID();
-			ImGui::NextColumn();
 		}
-								break;
-		case nbt::tag_type::Short: {
-			nbt::tag_short value = tag.second->as<nbt::tag_short>();
-			log::trace("TAG_SHORT: {}", value.get());
-			json[tag.first] = value.get();
-
-			renderKey(tag.first, "short", false);
-			ImGui::NextColumn();
-			ImGui::PushID(tag.first.c_str());
-			ImGui::Text(json[tag.first].dump().c_str());
-			ImGui::PopID();
-			ImGui::NextColumn();
+	}
+
+	// The old per-tag trace output, only run when trace logging is actually enabled
+	class NbtTraceVisitor : public NbtVisitor {
+	public:
+		explicit NbtTraceVisitor(const char* header) : header(header) {}
+
+		void Value(const std::string& name, const nbt::tag& tag) override {
+			log::trace("{}NBT Tag: {} = {}", makeIndent(indent, header), name,
+				NbtValueToJson(tag).dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore));
 		}
-								 break;
-		case nbt::tag_type::Int: {
-			nbt::tag_int value = tag.second->as<nbt::tag_int>();
-			log::trace("TAG_INT: {}", value.get());
-			json[tag.first] = value.get();
-
-			renderKey(tag.first, "int", false);
-			ImGui::NextColumn();
-			ImGui::PushID(tag.first.c_str());
-			ImGui::Text(json[tag.first].dump().c_str());
-			ImGui::PopID();
-			ImGui::NextColumn();
+
+		bool BeginContainer(const std::string& name, const nbt::tag& tag) override {
+			bool is_list = tag.get_type() == nbt::tag_type::List;
+
+			log::trace("{}NBT Tag: {} {}-{} {{", makeIndent(indent, header), name, is_list ? "LIST" : "COMPOUND", container_number++);
+			indent++;
+
+			return true;
 		}
-							   break;
-		case nbt::tag_type::Long: {
-			nbt::tag_long value = tag.second->as<nbt::tag_long>();
-			log::trace("TAG_LONG: {}", value.get());
-			json[tag.first] = value.get();
-
-			renderKey(tag.first, "long", false);
-			ImGui::NextColumn();
-			ImGui::PushID(tag.first.c_str());
-			ImGui::Text(json[tag.first].dump().c_str());
-			ImGui::PopID();
-			ImGui::NextColumn();
+
+		void EndContainer(const std::string&, const nbt::tag&) override {
+			if (--indent < 0)
+				indent = 0;
+
+			log::trace("{}}}", makeIndent(indent, header));
 		}
-								break;
-		case nbt::tag_type::Float: {
-			nbt::tag_float value = tag.second->as<nbt::tag_float>();
-			log::trace("TAG_FLOAT: {}", value.get());
-			json[tag.first] = value.get();
-
-			renderKey(tag.first, "float", false);
-			ImGui::NextColumn();
-			ImGui::PushID(tag.first.c_str());
-			ImGui::Text(json[tag.first].dump().c_str());
-			ImGui::PopID();
-			ImGui::NextColumn();
+
+	private:
+		const char* header;
+		int32_t indent = 0;
+		int32_t container_number = 0;
+	};
+
+	class NbtJsonVisitor : public NbtVisitor {
+	public:
+		nlohmann::json root = nlohmann::json::array();
+
+		void Value(const std::string& name, const nbt::tag& tag) override {
+			Add(name, NbtValueToJson(tag));
 		}
-								 break;
-		case nbt::tag_type::Double: {
-			nbt::tag_double value = tag.second->as<nbt::tag_double>();
-			log::trace("TAG_DOUBLE: {}", value.get());
-			json[tag.first] = value.get();
-
-			renderKey(tag.first, "double", false);
-			ImGui::NextColumn();
-			ImGui::PushID(tag.first.c_str());
-			ImGui::Text(json[tag.first].dump().c_str());
-			ImGui::PopID();
-			ImGui::NextColumn();
+
+		bool BeginContainer(const std::string& name, const nbt::tag& tag) override {
+			bool is_list = tag.get_type() == nbt::tag_type::List;
+
+			stack.push_back(&Add(name, is_list ? nlohmann::json::array() : nlohmann::json::object()));
+
+			return true;
 		}
-								  break;
-		case nbt::tag_type::Byte_Array:
-			break;
-		case nbt::tag_type::String: {
-			nbt::tag_string value = tag.second->as<nbt::tag_string>();
-			log::trace("TAG_STRING: {}", value.get());
-			json[tag.first] = value.get();
-
-			renderKey(tag.first, "string", false);
-			ImGui::NextColumn();
-			ImGui::PushID(tag.first.c_str());
-			ImGui::Text(json[tag.first].dump().c_str());
-			ImGui::PopID();
-			ImGui::NextColumn();
+
+		void EndContainer(const std::string&, const nbt::tag&) override {
+			stack.pop_back();
 		}
-								  break;
-		case nbt::tag_type::List: {
-			nbt::tag_list value = tag.second->as<nbt::tag_list>();
-			int32_t list_number = global_nbt_compound_number++;
-			log::trace("LIST-{} {{", list_number);
-			indent++;
 
-			bool need_open = renderKey(tag.first, "compound", true);
-			ImGui::NextColumn();
-			ImGui::PushID((tag.first.c_str()));
-			ImGui::Text("entries");
-			ImGui::PopID();
-			ImGui::NextColumn();
+	private:
+		// Parents are never modified while one of their children is on the stack, so these stay valid
+		std::vector<nlohmann::json*> stack;
 
-			if (need_open) {
-				for (const auto& nbt_tag : value) {
-					json[tag.first].update(ParseNbtTag(header, indent, std::make_pair(std::string(""), nbt_tag.get().clone())));
-				}
-				if (--indent < 0)
-					indent = 0;
-				log::trace("{}}} LIST-{}", makeIndent(indent, header), list_number);
-				ImGui::TreePop();
+		nlohmann::json& Add(const std::string& name, nlohmann::json value) {
+			if (stack.empty()) {
+				root.push_back({ { name, std::move(value) } });
+
+				return root.back()[name];
 			}
-		}
-								break;
-		case nbt::tag_type::Compound: {
-			nbt::tag_compound value = tag.second->as<nbt::tag_compound>();
-			int32_t compound_number = global_nbt_compound_number++;
-			log::trace("TAG_COMPOUND: {} ({} tags)", compound_number, value.size());
-			indent++;
 
-			bool need_open = renderKey(tag.first, "compound", true);
-			ImGui::NextColumn();
-			ImGui::PushID((tag.first.c_str()));
-			ImGui::Text("entries");
-			ImGui::PopID();
-			ImGui::NextColumn();
+			nlohmann::json& parent = *stack.back();
 
-			if (need_open) {
-				for (const auto& nbt_tag : value) {
-					json[tag.first].update(ParseNbtTag(header, indent, std::make_pair(nbt_tag.first, nbt_tag.second.get().clone())));
-				}
-				if (indent-- < 0)
-					indent = 0;
-				log::trace("{}}} COMPOUND-{}", makeIndent(indent, header), compound_number);
-				ImGui::TreePop();
+			if (parent.is_array()) {
+				parent.push_back(std::move(value));
+
+				return parent.back();
 			}
-		}
-									break;
-		case nbt::tag_type::Int_Array:
-			break;
-		case nbt::tag_type::Long_Array:
-			break;
-		default:
-			break;
-		}
 
-		return json;
-	}
+			return parent[name] = std::move(value);
+		}
+	};
+} // namespace
 
-	std::pair<int32_t, nlohmann::json> ParseNbt(const char* header, const char* buffer, int32_t buffer_length, NbtTagList& tag_list) {
-		int32_t indent = 0;
-		log::trace("{}NBT Decode Start", makeIndent(indent, header));
-		global_nbt_list_number = 0;
-		global_nbt_compound_number = 0;
+namespace smokey_bedrock_parser {
+	int32_t ParseNbt(const char* header, const char* buffer, int32_t buffer_length, NbtTagList& tag_list) {
+		SBP_LOG_TRACE("{}NBT Decode Start", header);
 		std::istringstream iss(std::string(buffer, buffer_length));
 		nbt::io::stream_reader reader(iss, endian::little);
 		tag_list.clear();
-		NbtTag tag;
 		bool done = false;
 		std::istream& stream = reader.get_istr();
 
@@ -235,17 +141,55 @@ namespace smokey_bedrock_parser {
 			}
 		}
 
-		NbtJson nbt_json;
-		nbt_json.name = "nbt";
+		if (log::enabled(Level::Trace)) {
+			NbtTraceVisitor trace_visitor(header);
+
+			VisitNbt(tag_list, trace_visitor);
+		}
+
+		SBP_LOG_TRACE("{}NBT Decode End ({} tags)", header, tag_list.size());
+
+		return tag_list.empty() ? -1 : 0;
+	}
+
+	void VisitNbt(const NbtTagList& tag_list, NbtVisitor& visitor) {
+		for (const auto& tag : tag_list)
+			VisitTag(tag.first, *tag.second, visitor);
+	}
 
-		for (const auto& nbt_tag : tag_list) {
-			nbt_json.nbt.push_back(ParseNbtTag(header, indent, nbt_tag));
+	nlohmann::json NbtValueToJson(const nbt::tag& tag) {
+		switch (tag.get_type()) {
+		case nbt::tag_type::Byte:
+			return tag.as<nbt::tag_byte>().get();
+		case nbt::tag_type::Short:
+			return tag.as<nbt::tag_short>().get();
+		case nbt::tag_type::Int:
+			return tag.as<nbt::tag_int>().get();
+		case nbt::tag_type::Long:
+			return tag.as<nbt::tag_long>().get();
+		case nbt::tag_type::Float:
+			return tag.as<nbt::tag_float>().get();
+		case nbt::tag_type::Double:
+			return tag.as<nbt::tag_double>().get();
+		case nbt::tag_type::String:
+			return tag.as<nbt::tag_string>().get();
+		case nbt::tag_type::Byte_Array:
+			return tag.as<nbt::tag_byte_array>().get();
+		case nbt::tag_type::Int_Array:
+			return tag.as<nbt::tag_int_array>().get();
+		case nbt::tag_type::Long_Array:
+			return tag.as<nbt::tag_long_array>().get();
+		default:
+			return nullptr;
 		}
+	}
+
+	nlohmann::json NbtToJson(const NbtTagList& tag_list) {
+		NbtJsonVisitor json_visitor;
 
-		log::trace("{}NBT Decode End ({} tags)", makeIndent(indent, header), tag_list.size());
-		//log::info("{}", nbt_json.nbt.dump(4, ' ', false, nlohmann::detail::error_handler_t::ignore));
+		VisitNbt(tag_list, json_visitor);
 
-		return std::make_pair(0, nbt_json.nbt);
+		return json_visitor.root;
 	}
 
 	class VillageInfo {
@@ -0,0 +1,169 @@
+#include "nbt_reader.h"
+
+namespace {
+	// Same nesting limit as the game, also keeps hostile data from overflowing the stack
+	constexpr int32_t max_depth = 512;
+
+	// Payload size of the fixed size tags, 0 for everything else
+	size_t PayloadSize(smokey_bedrock_parser::NbtTagType type) {
+		using smokey_bedrock_parser::NbtTagType;
+
+		switch (type) {
+		case NbtTagType::Byte:
+			return 1;
+		case NbtTagType::Short:
+			return 2;
+		case NbtTagType::Int:
+		case NbtTagType::Float:
+			return 4;
+		case NbtTagType::Long:
+		case NbtTagType::Double:
+			return 8;
+		default:
+			return 0;
+		}
+	}
+
+	size_t ElementSize(smokey_bedrock_parser::NbtTagType type) {
+		using smokey_bedrock_parser::NbtTagType;
+
+		switch (type) {
+		case NbtTagType::ByteArray:
+			return 1;
+		case NbtTagType::IntArray:
+			return 4;
+		case NbtTagType::LongArray:
+			return 8;
+		default:
+			return 0;
+		}
+	}
+} // namespace
+
+namespace smokey_bedrock_parser {
+	bool NbtReader::ReadTagHeader(NbtTagType& type, std::string_view& name) {
+		uint8_t id;
+
+		if (!ReadScalar(id)) return false;
+
+		if (id > uint8_t(NbtTagType::LongArray)) return Fail();
+
+		type = NbtTagType(id);
+		name = std::string_view();
+
+		if (type == NbtTagType::End) return true;
+
+		return ReadString(name);
+	}
+
+	bool NbtReader::ReadString(std::string_view& value) {
+		uint16_t length;
+
+		if (!ReadScalar(length)) return false;
+
+		const char* start = buffer + offset;
+
+		if (!Advance(length)) return false;
+
+		value = std::string_view(start, length);
+
+		return true;
+	}
+
+	bool NbtReader::ReadListHeader(NbtTagType& element_type, int32_t& count) {
+		uint8_t id;
+
+		if (!ReadScalar(id) || !ReadScalar(count)) return false;
+
+		if (id > uint8_t(NbtTagType::LongArray) || count < 0) return Fail();
+
+		element_type = NbtTagType(id);
+
+		return true;
+	}
+
+	bool NbtReader::ReadArray(NbtTagType type, int32_t& count, const char*& data) {
+		size_t element_size = ElementSize(type);
+
+		if (element_size == 0) return Fail();
+
+		if (!ReadScalar(count)) return false;
+
+		if (count < 0) return Fail();
+
+		data = buffer + offset;
+
+		return Advance(size_t(count) * element_size);
+	}
+
+	bool NbtReader::SkipTag() {
+		NbtTagType type;
+		std::string_view name;
+
+		if (!ReadTagHeader(type, name)) return false;
+
+		return type == NbtTagType::End || SkipPayload(type);
+	}
+
+	bool NbtReader::SkipPayload(NbtTagType type, int32_t depth) {
+		if (depth > max_depth) return Fail();
+
+		switch (type) {
+		case NbtTagType::End:
+			return true;
+		case NbtTagType::Byte:
+			return Advance(1);
+		case NbtTagType::Short:
+			return Advance(2);
+		case NbtTagType::Int:
+		case NbtTagType::Float:
+			return Advance(4);
+		case NbtTagType::Long:
+		case NbtTagType::Double:
+			return Advance(8);
+		case NbtTagType::ByteArray:
+		case NbtTagType::IntArray:
+		case NbtTagType::LongArray: {
+			int32_t count;
+			const char* data;
+
+			return ReadArray(type, count, data);
+		}
+		case NbtTagType::String: {
+			uint16_t length;
+
+			return ReadScalar(length) && Advance(length);
+		}
+		case NbtTagType::List: {
+			NbtTagType element_type;
+			int32_t count;
+
+			if (!ReadListHeader(element_type, count)) return false;
+
+			if (element_type == NbtTagType::End) return true;
+
+			// Lists of numbers can be stepped over in one go
+			if (PayloadSize(element_type) != 0) return Advance(size_t(count) * PayloadSize(element_type));
+
+			for (int32_t i = 0; i < count; i++)
+				if (!SkipPayload(element_type, depth + 1)) return false;
+
+			return true;
+		}
+		case NbtTagType::Compound: {
+			NbtTagType child_type;
+			std::string_view name;
+
+			while (ReadTagHeader(child_type, name)) {
+				if (child_type == NbtTagType::End) return true;
+
+				if (!SkipPayload(child_type, depth + 1)) return false;
+			}
+
+			return false;
+		}
+		default:
+			return Fail();
+		}
+	}
+} // namespace smokey_bedrock_parser
@@ -0,0 +1,169 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "json.hpp"
+#include "logger.h"
+
+namespace {
+	struct Event {
+		const char* name;
+		const char* arg_name;
+		int64_t arg_value;
+		double start;
+		double duration;
+	};
+
+	/**
+		One per thread that recorded something. Only its own thread appends, the mutex is there for Stop and is
+		never contended otherwise. Buffers outlive their threads so nothing a finished worker recorded is lost.
+	*/
+	struct ThreadBuffer {
+		std::mutex mutex;
+		std::vector<Event> events;
+		std::string thread_name;
+		uint32_t thread_id;
+		bool finished = false;
+	};
+
+	std::mutex buffers_mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	uint32_t next_thread_id = 1;
+	// steady_clock nanoseconds of the last Start, read by every span
+	std::atomic<int64_t> trace_start(0);
+
+	int64_t SteadyNanoseconds() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Marks the thread's buffer as finished when the thread exits, Stop then frees it
+	struct ThreadBufferHandle {
+		ThreadBuffer* buffer = nullptr;
+
+		~ThreadBufferHandle() {
+			if (buffer == nullptr) return;
+
+			std::lock_guard<std::mutex> lock(buffer->mutex);
+
+			buffer->finished = true;
+		}
+	};
+
+	ThreadBuffer& GetThreadBuffer() {
+		thread_local ThreadBufferHandle handle;
+
+		if (handle.buffer == nullptr) {
+			std::lock_guard<std::mutex> lock(buffers_mutex);
+
+			buffers.push_back(std::make_unique<ThreadBuffer>());
+			handle.buffer = buffers.back().get();
+			handle.buffer->thread_id = next_thread_id++;
+		}
+
+		return *handle.buffer;
+	}
+} // namespace
+
+namespace smokey_bedrock_parser {
+	namespace trace {
+		namespace detail {
+			std::atomic<bool> tracing(false);
+		}
+
+		void Start() {
+			std::lock_guard<std::mutex> lock(buffers_mutex);
+
+			for (auto& buffer : buffers) {
+				std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+
+				buffer->events.clear();
+			}
+
+			trace_start = SteadyNanoseconds();
+			detail::tracing = true;
+		}
+
+		int32_t Stop(const std::filesystem::path& path) {
+			detail::tracing = false;
+
+			nlohmann::json events = nlohmann::json::array();
+
+			{
+				std::lock_guard<std::mutex> lock(buffers_mutex);
+
+				for (auto& buffer : buffers) {
+					std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+
+					if (!buffer->thread_name.empty())
+						events.push_back({ { "ph", "M" }, { "name", "thread_name" }, { "pid", 1 }, { "tid", buffer->thread_id },
+							{ "args", { { "name", buffer->thread_name } } } });
+
+					for (const Event& event : buffer->events) {
+						nlohmann::json entry = { { "ph", "X" }, { "name", event.name }, { "cat", "sbp" }, { "pid", 1 },
+							{ "tid", buffer->thread_id }, { "ts", event.start }, { "dur", event.duration } };
+
+						if (event.arg_name != nullptr)
+							entry["args"] = { { event.arg_name, event.arg_value } };
+
+						events.push_back(std::move(entry));
+					}
+
+					buffer->events.clear();
+				}
+
+				buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [](const std::unique_ptr<ThreadBuffer>& buffer) {
+					return buffer->finished;
+				}), buffers.end());
+			}
+
+			FILE* file = fopen(path.string().c_str(), "w");
+
+			if (!file) {
+				log::error("Failed to open trace file (file name={} | error={} ({}))", path.string(), strerror(errno), errno);
+
+				return -1;
+			}
+
+			nlohmann::json trace = { { "traceEvents", std::move(events) }, { "displayTimeUnit", "ms" } };
+			std::string text = trace.dump();
+
+			fwrite(text.data(), 1, text.size(), file);
+			fclose(file);
+
+			log::info("Wrote {} trace events to {}", trace["traceEvents"].size(), path.string());
+
+			return 0;
+		}
+
+		void SetThreadName(const std::string& name) {
+			if (!enabled()) return;
+
+			ThreadBuffer& buffer = GetThreadBuffer();
+			std::lock_guard<std::mutex> lock(buffer.mutex);
+
+			buffer.thread_name = name;
+		}
+
+		double Now() {
+			return (SteadyNanoseconds() - trace_start.load(std::memory_order_relaxed)) / 1e3;
+		}
+
+		void ScopedSpan::End() {
+			// Started before a Stop, the trace it belonged to has already been written
+			if (!enabled()) return;
+
+			double end = Now();
+			ThreadBuffer& buffer = GetThreadBuffer();
+			std::lock_guard<std::mutex> lock(buffer.mutex);
+
+			buffer.events.push_back({ name, arg_name, arg_value, start, end - start });
+		}
+	}
+} // namespace smokey_bedrock_parser
@@ -0,0 +1,215 @@
+#include "world/block_registry.h"
+
+#include <functional>
+#include <stdexcept>
+
+namespace {
+	constexpr size_t initial_capacity = 64;
+
+	// What EncodeBlockStates makes of no properties at all, a lone end tag
+	constexpr std::string_view empty_states("\0", 1);
+
+	uint64_t HashKey(std::string_view name, std::string_view states) {
+		uint64_t key = std::hash<std::string_view>()(name) * 0x9e3779b97f4a7c15ULL ^ std::hash<std::string_view>()(states);
+
+		key ^= key >> 30;
+		key *= 0xbf58476d1ce4e5b9ULL;
+		key ^= key >> 27;
+		key *= 0x94d049bb133111ebULL;
+		key ^= key >> 31;
+
+		return key;
+	}
+
+	/**
+		The slot index takes the low bits of the hash and the slot tag the high 32, so the shard comes from the
+		bits in between. Taking it from the low bits would give every key of a shard the same hash mod 64 and bunch
+		all their probes onto 1/64 of the slots.
+	*/
+	size_t ShardIndex(uint64_t hash) {
+		return size_t(hash >> 26) % smokey_bedrock_parser::BlockRegistry::kShardCount;
+	}
+
+	uint64_t MakeSlot(uint64_t hash, uint32_t id) {
+		return (hash & 0xffffffff00000000ULL) | (uint64_t(id) + 1);
+	}
+} // namespace
+
+namespace smokey_bedrock_parser {
+	BlockRegistry::ProbeTable::ProbeTable(size_t capacity) : mask(capacity - 1), slots(new std::atomic<uint64_t>[capacity]) {
+		for (size_t i = 0; i < capacity; i++)
+			slots[i].store(0, std::memory_order_relaxed);
+	}
+
+	BlockRegistry::BlockRegistry() : segments(new std::atomic<BlockState*>[kMaxSegments]) {
+		for (size_t i = 0; i < kMaxSegments; i++)
+			segments[i].store(nullptr, std::memory_order_relaxed);
+
+		for (Shard& shard : shards) {
+			shard.tables.push_back(std::make_unique<ProbeTable>(initial_capacity));
+			shard.table.store(shard.tables.back().get(), std::memory_order_release);
+		}
+	}
+
+	BlockRegistry::~BlockRegistry() {
+		for (size_t i = 0; i < kMaxSegments; i++)
+			delete[] segments[i].load(std::memory_order_relaxed);
+	}
+
+	BlockRegistry& BlockRegistry::Instance() {
+		static BlockRegistry registry;
+
+		return registry;
+	}
+
+	uint32_t BlockRegistry::Probe(const ProbeTable* table, uint64_t hash, std::string_view name, std::string_view states) const {
+		size_t index = hash & table->mask;
+
+		while (true) {
+			uint64_t slot = table->slots[index].load(std::memory_order_acquire);
+
+			if (slot == 0) return kInvalidBlockId;
+
+			if ((slot >> 32) == (hash >> 32)) {
+				uint32_t id = uint32_t(slot) - 1;
+				const BlockState& state = get_state(id);
+
+				if (state.name == name && state.states == states) return id;
+			}
+
+			index = (index + 1) & table->mask;
+		}
+	}
+
+	uint32_t BlockRegistry::FindExact(std::string_view name, std::string_view states) const {
+		uint64_t hash = HashKey(name, states);
+		const Shard& shard = shards[ShardIndex(hash)];
+
+		return Probe(shard.table.load(std::memory_order_acquire), hash, name, states);
+	}
+
+	uint32_t BlockRegistry::Find(std::string_view name, std::string_view states) const {
+		if (states.empty())
+			states = empty_states;
+
+		uint32_t id = FindExact(name, states);
+
+		if (id != kInvalidBlockId) return id;
+
+		BlockState state = Canonicalize(name, states);
+
+		return FindExact(state.name, state.states);
+	}
+
+	uint32_t BlockRegistry::Intern(std::string_view name, std::string_view states) {
+		// Entries without a states compound would otherwise never match their own canonical form
+		if (states.empty())
+			states = empty_states;
+
+		// Bedrock writes states sorted by name, so the raw bytes are almost always canonical already
+		uint32_t id = FindExact(name, states);
+
+		if (id != kInvalidBlockId) return id;
+
+		return Insert(Canonicalize(name, states));
+	}
+
+	BlockState BlockRegistry::Canonicalize(std::string_view name, std::string_view states) {
+		BlockState state;
+
+		state.name = std::string(name);
+
+		if (DecodeBlockStates(states, state.properties)) {
+			state.states = EncodeBlockStates(state.properties);
+			state.state_hash = HashBlockStates(state.properties);
+		}
+		else {
+			// Keep what we cannot decode as is, it still gets an ID of its own
+			state.states = std::string(states);
+		}
+
+		return state;
+	}
+
+	uint32_t BlockRegistry::Insert(BlockState&& state) {
+		uint64_t hash = HashKey(state.name, state.states);
+		Shard& shard = shards[ShardIndex(hash)];
+		uint32_t id = Probe(shard.table.load(std::memory_order_acquire), hash, state.name, state.states);
+
+		if (id != kInvalidBlockId) return id;
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		// Another thread may have added it between the lock-free probe and taking the lock
+		id = Probe(shard.table.load(std::memory_order_relaxed), hash, state.name, state.states);
+
+		if (id != kInvalidBlockId) return id;
+
+		if ((shard.count + 1) * 2 > shard.table.load(std::memory_order_relaxed)->mask + 1)
+			Grow(shard);
+
+		id = Append(std::move(state));
+
+		ProbeTable* table = shard.table.load(std::memory_order_relaxed);
+		size_t index = hash & table->mask;
+
+		while (table->slots[index].load(std::memory_order_relaxed) != 0)
+			index = (index + 1) & table->mask;
+
+		table->slots[index].store(MakeSlot(hash, id), std::memory_order_release);
+		shard.count++;
+
+		return id;
+	}
+
+	uint32_t BlockRegistry::Append(BlockState&& state) {
+		uint32_t id = next_id.load(std::memory_order_relaxed);
+
+		// Reserve the ID first; shards insert concurrently so the counter is the only shared state
+		while (!next_id.compare_exchange_weak(id, id + 1, std::memory_order_relaxed))
+			;
+
+		size_t segment_index = id / kSegmentSize;
+
+		if (segment_index >= kMaxSegments)
+			throw std::length_error("Block registry is full");
+
+		BlockState* segment = segments[segment_index].load(std::memory_order_acquire);
+
+		if (segment == nullptr) {
+			BlockState* new_segment = new BlockState[kSegmentSize];
+
+			if (segments[segment_index].compare_exchange_strong(segment, new_segment, std::memory_order_acq_rel))
+				segment = new_segment;
+			else
+				delete[] new_segment;
+		}
+
+		// The slot is published with release semantics afterwards, so readers never see a half-written state
+		segment[id % kSegmentSize] = std::move(state);
+
+		return id;
+	}
+
+	void BlockRegistry::Grow(Shard& shard) {
+		const ProbeTable* old_table = shard.table.load(std::memory_order_relaxed);
+		auto new_table = std::make_unique<ProbeTable>((old_table->mask + 1) * 2);
+
+		for (size_t i = 0; i <= old_table->mask; i++) {
+			uint64_t slot = old_table->slots[i].load(std::memory_order_relaxed);
+
+			if (slot == 0) continue;
+
+			const BlockState& state = get_state(uint32_t(slot) - 1);
+			size_t index = HashKey(state.name, state.states) & new_table->mask;
+
+			while (new_table->slots[index].load(std::memory_order_relaxed) != 0)
+				index = (index + 1) & new_table->mask;
+
+			new_table->slots[index].store(slot, std::memory_order_relaxed);
+		}
+
+		shard.table.store(new_table.get(), std::memory_order_release);
+		shard.tables.push_back(std::move(new_table));
+	}
+} // namespace smokey_bedrock_parser
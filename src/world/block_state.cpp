@@ -0,0 +1,133 @@
+#include "world/block_state.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+	using namespace smokey_bedrock_parser;
+
+	uint64_t Mix(uint64_t key) {
+		key ^= key >> 30;
+		key *= 0xbf58476d1ce4e5b9ULL;
+		key ^= key >> 27;
+		key *= 0x94d049bb133111ebULL;
+		key ^= key >> 31;
+
+		return key;
+	}
+
+	void AppendString(std::string& buffer, std::string_view value) {
+		uint16_t length = uint16_t(value.size());
+
+		buffer.append((const char*)&length, 2);
+		buffer.append(value);
+	}
+} // namespace
+
+namespace smokey_bedrock_parser {
+	const BlockProperty* BlockState::get_property(std::string_view name) const {
+		for (const BlockProperty& property : properties)
+			if (property.name == name) return &property;
+
+		return nullptr;
+	}
+
+	bool DecodeBlockStates(std::string_view states, std::vector<BlockProperty>& properties) {
+		NbtReader reader(states.data(), states.size());
+
+		properties.clear();
+
+		// Palette entries without a states compound have no properties
+		if (states.empty()) return true;
+
+		bool decoded = reader.ForEachInCompound([&](NbtTagType type, std::string_view name) {
+			BlockProperty property;
+
+			property.name = std::string(name);
+			property.type = type;
+
+			switch (type) {
+			case NbtTagType::Byte: {
+				int8_t value;
+
+				if (!reader.ReadByte(value)) return false;
+
+				property.number = value;
+
+				break;
+			}
+			case NbtTagType::Int:
+				if (!reader.ReadInt(property.number)) return false;
+
+				break;
+			case NbtTagType::String: {
+				std::string_view value;
+
+				if (!reader.ReadString(value)) return false;
+
+				property.text = std::string(value);
+
+				break;
+			}
+			default:
+				return false;
+			}
+
+			properties.push_back(std::move(property));
+
+			return true;
+		});
+
+		if (!decoded || !reader.at_end()) return false;
+
+		std::sort(properties.begin(), properties.end(), [](const BlockProperty& a, const BlockProperty& b) {
+			return a.name < b.name;
+		});
+
+		return true;
+	}
+
+	std::string EncodeBlockStates(const std::vector<BlockProperty>& properties) {
+		std::string buffer;
+
+		for (const BlockProperty& property : properties) {
+			buffer += char(property.type);
+			AppendString(buffer, property.name);
+
+			switch (property.type) {
+			case NbtTagType::Byte:
+				buffer += char(int8_t(property.number));
+
+				break;
+			case NbtTagType::Int:
+				buffer.append((const char*)&property.number, 4);
+
+				break;
+			default:
+				AppendString(buffer, property.text);
+
+				break;
+			}
+		}
+
+		buffer += char(NbtTagType::End);
+
+		return buffer;
+	}
+
+	uint64_t HashBlockStates(const std::vector<BlockProperty>& properties) {
+		uint64_t hash = 0;
+
+		// Summing the per-property hashes makes the result independent of their order
+		for (const BlockProperty& property : properties) {
+			uint64_t key = std::hash<std::string>()(property.name);
+
+			key = Mix(key ^ (uint64_t(property.type) << 56));
+			key = Mix(key ^ uint64_t(uint32_t(property.number)));
+			key = Mix(key ^ std::hash<std::string>()(property.text));
+			hash += key;
+		}
+
+		return Mix(hash + properties.size());
+	}
+} // namespace smokey_bedrock_parser
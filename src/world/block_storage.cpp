@@ -0,0 +1,298 @@
+#include "world/block_storage.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SBP_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define SBP_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#include "logger.h"
+
+/**
+	Bedrock packs palette indices into little-endian 32-bit words, floor(32 / bits) indices per word, lowest bits
+	first, and never lets an index straddle two words. For 1, 2, 4, 8 and 16 bits per block no padding bits are
+	left over, so the storage is a plain bit stream and can be expanded a whole vector at a time. The other widths
+	(3, 5 and 6) leave 2 padding bits per word and are expanded one word at a time.
+*/
+namespace {
+	using smokey_bedrock_parser::kBlockStorageSize;
+
+	using smokey_bedrock_parser::BlockStorageFormat;
+	using smokey_bedrock_parser::BlockStorageView;
+
+	template <int Bits>
+	void UnpackScalar(const char* words, uint16_t* indices) {
+		constexpr int32_t blocks_per_word = BlockStorageView<Bits>::kBlocksPerWord;
+		constexpr int32_t full_words = kBlockStorageSize / blocks_per_word;
+		constexpr int32_t tail_blocks = kBlockStorageSize % blocks_per_word;
+		constexpr uint32_t mask = BlockStorageView<Bits>::kMask;
+
+		for (int32_t w = 0; w < full_words; w++) {
+			uint32_t word;
+
+			memcpy(&word, words + w * 4, 4);
+
+			for (int32_t i = 0; i < blocks_per_word; i++)
+				indices[w * blocks_per_word + i] = uint16_t((word >> (i * Bits)) & mask);
+		}
+
+		if (tail_blocks != 0) {
+			uint32_t word;
+
+			memcpy(&word, words + full_words * 4, 4);
+
+			for (int32_t i = 0; i < tail_blocks; i++)
+				indices[full_words * blocks_per_word + i] = uint16_t((word >> (i * Bits)) & mask);
+		}
+	}
+
+
+#ifdef SBP_HAVE_SSE2
+	// Interleaves byte planes so that value j of every plane ends up next to each other, in plane order.
+	// planes[k] holds bits [k * Bits, (k + 1) * Bits) of 16 source bytes. With n = 8 / Bits planes the result
+	// is n registers holding 16 * n one-byte indices in stream order.
+	inline void Interleave2(__m128i a, __m128i b, __m128i* out) {
+		out[0] = _mm_unpacklo_epi8(a, b);
+		out[1] = _mm_unpackhi_epi8(a, b);
+	}
+
+	inline void Interleave4(const __m128i* planes, __m128i* out) {
+		__m128i a[2], b[2];
+
+		Interleave2(planes[0], planes[1], a);
+		Interleave2(planes[2], planes[3], b);
+
+		out[0] = _mm_unpacklo_epi16(a[0], b[0]);
+		out[1] = _mm_unpackhi_epi16(a[0], b[0]);
+		out[2] = _mm_unpacklo_epi16(a[1], b[1]);
+		out[3] = _mm_unpackhi_epi16(a[1], b[1]);
+	}
+
+	inline void Interleave8(const __m128i* planes, __m128i* out) {
+		__m128i a[4], b[4];
+
+		Interleave4(planes, a);
+		Interleave4(planes + 4, b);
+
+		for (int32_t i = 0; i < 4; i++) {
+			out[i * 2] = _mm_unpacklo_epi32(a[i], b[i]);
+			out[i * 2 + 1] = _mm_unpackhi_epi32(a[i], b[i]);
+		}
+	}
+
+	inline void StoreWidened(__m128i bytes, uint16_t* indices) {
+		const __m128i zero = _mm_setzero_si128();
+
+		_mm_storeu_si128((__m128i*)indices, _mm_unpacklo_epi8(bytes, zero));
+		_mm_storeu_si128((__m128i*)(indices + 8), _mm_unpackhi_epi8(bytes, zero));
+	}
+
+	template <int Bits>
+	void UnpackBitStreamSSE2(const char* words, uint16_t* indices) {
+		static_assert(Bits == 1 || Bits == 2 || Bits == 4 || Bits == 8, "bit stream widths only");
+		constexpr int32_t plane_count = 8 / Bits;
+		constexpr int32_t stream_bytes = kBlockStorageSize * Bits / 8;
+		const __m128i mask = _mm_set1_epi8(char((1 << Bits) - 1));
+
+		for (int32_t offset = 0; offset < stream_bytes; offset += 16) {
+			__m128i source = _mm_loadu_si128((const __m128i*)(words + offset));
+
+			if constexpr (plane_count == 1) {
+				StoreWidened(source, indices);
+			}
+			else {
+				// 16-bit shifts are fine here, the bits that leak in from the neighbouring byte are masked off
+				__m128i planes[plane_count];
+
+				for (int32_t k = 0; k < plane_count; k++)
+					planes[k] = _mm_and_si128(_mm_srli_epi16(source, k * Bits), mask);
+
+				__m128i ordered[plane_count];
+
+				if constexpr (plane_count == 2)
+					Interleave2(planes[0], planes[1], ordered);
+				else if constexpr (plane_count == 4)
+					Interleave4(planes, ordered);
+				else
+					Interleave8(planes, ordered);
+
+				for (int32_t k = 0; k < plane_count; k++)
+					StoreWidened(ordered[k], indices + k * 16);
+			}
+
+			indices += plane_count * 16;
+		}
+	}
+#endif
+
+#ifdef SBP_HAVE_AVX2
+	// One word per iteration: broadcast it, shift each lane by its own offset and mask. The 8-lane store runs past
+	// the blocks of the current word into the next one, which the next iteration overwrites. With fewer than 8
+	// blocks per word the last store can land up to two words from the end, so the vector loop stops as soon as a
+	// store would leave the output array and the remaining words are done in scalar code.
+	template <int Bits>
+	void UnpackPaddedAVX2(const char* words, uint16_t* indices) {
+		constexpr int32_t blocks_per_word = BlockStorageView<Bits>::kBlocksPerWord;
+		constexpr int32_t word_count = BlockStorageView<Bits>::kWordCount;
+		constexpr uint32_t mask = BlockStorageView<Bits>::kMask;
+		const __m256i shifts = _mm256_setr_epi32(0, Bits, 2 * Bits, 3 * Bits, 4 * Bits, 5 * Bits, 6 * Bits, 7 * Bits);
+		const __m256i lane_mask = _mm256_set1_epi32(mask);
+		int32_t w = 0;
+
+		for (; w < word_count && w * blocks_per_word + 8 <= kBlockStorageSize; w++) {
+			uint32_t word;
+
+			memcpy(&word, words + w * 4, 4);
+
+			__m256i values = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(word), shifts), lane_mask);
+			__m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+
+			_mm_storeu_si128((__m128i*)(indices + w * blocks_per_word), packed);
+
+			for (int32_t i = 8; i < blocks_per_word; i++)
+				indices[w * blocks_per_word + i] = uint16_t((word >> (i * Bits)) & mask);
+		}
+
+		for (; w < word_count; w++) {
+			uint32_t word;
+
+			memcpy(&word, words + w * 4, 4);
+
+			for (int32_t i = 0; i < blocks_per_word && w * blocks_per_word + i < kBlockStorageSize; i++)
+				indices[w * blocks_per_word + i] = uint16_t((word >> (i * Bits)) & mask);
+		}
+	}
+#endif
+
+	template <int Bits>
+	void Unpack(const char* words, uint16_t* indices) {
+#if defined(SBP_HAVE_SSE2)
+		if constexpr (Bits == 1 || Bits == 2 || Bits == 4 || Bits == 8) {
+			UnpackBitStreamSSE2<Bits>(words, indices);
+			return;
+		}
+#endif
+#if defined(SBP_HAVE_AVX2)
+		if constexpr (Bits == 3 || Bits == 5 || Bits == 6) {
+			UnpackPaddedAVX2<Bits>(words, indices);
+			return;
+		}
+#endif
+		if constexpr (Bits == 16) {
+			// Two indices per word, which on a little-endian host is already an array of uint16_t
+			memcpy(indices, words, kBlockStorageSize * sizeof(uint16_t));
+			return;
+		}
+
+		UnpackScalar<Bits>(words, indices);
+	}
+
+	template <int Bits>
+	uint16_t GetBlock(const char* words, int32_t index) {
+		return BlockStorageView<Bits>{ words }.Get(index);
+	}
+
+	template <int Bits>
+	void UnpackBlocks(const char* words, uint16_t* indices) {
+		BlockStorageView<Bits>{ words }.Unpack(indices);
+	}
+
+	template <int Bits>
+	constexpr BlockStorageFormat MakeFormat() {
+		return { Bits, BlockStorageView<Bits>::kBlocksPerWord, BlockStorageView<Bits>::kWordCount, &GetBlock<Bits>, &UnpackBlocks<Bits> };
+	}
+
+	// Indexed by the storage header byte. Bit 0 is the runtime flag, which never changes the layout.
+	constexpr std::array<BlockStorageFormat, 256> format_table = []() {
+		std::array<BlockStorageFormat, 256> table{};
+		const BlockStorageFormat formats[] = {
+			MakeFormat<0>(), MakeFormat<1>(), MakeFormat<2>(), MakeFormat<3>(), MakeFormat<4>(),
+			MakeFormat<5>(), MakeFormat<6>(), MakeFormat<8>(), MakeFormat<16>()
+		};
+
+		for (const auto& format : formats) {
+			table[format.bits_per_block << 1] = format;
+			table[(format.bits_per_block << 1) | 1] = format;
+		}
+
+		return table;
+	}();
+} // namespace
+
+namespace smokey_bedrock_parser {
+	template <int32_t Bits>
+	void BlockStorageView<Bits>::Unpack(uint16_t* indices) const {
+		::Unpack<Bits>(words, indices);
+	}
+
+	template struct BlockStorageView<1>;
+	template struct BlockStorageView<2>;
+	template struct BlockStorageView<3>;
+	template struct BlockStorageView<4>;
+	template struct BlockStorageView<5>;
+	template struct BlockStorageView<6>;
+	template struct BlockStorageView<8>;
+	template struct BlockStorageView<16>;
+
+	const BlockStorageFormat* GetBlockStorageFormat(uint8_t header) {
+		const BlockStorageFormat& format = format_table[header];
+
+		if (format.unpack == nullptr) return nullptr;
+
+		return &format;
+	}
+
+	// Only the version and storage header bytes are read, the word count and with it the palette offset come from the format table
+	int32_t SetupBlockStorage(const char* buffer, const BlockStorageFormat*& format, int32_t& block_offset,
+		int32_t& palette_offset) {
+		uint8_t header;
+
+		// Check sub-chunk version
+		switch (buffer[0]) {
+		case 0x01:
+			// v1 - [version:byte][block storage]
+			header = buffer[1];
+			block_offset = 2;
+
+			break;
+		case 0x08:
+			// v8 - [version:byte][num_storages:byte][block storage1]...[blockStorageN]
+			header = buffer[2];
+			block_offset = 3;
+
+			break;
+		case 0x09:
+			// https://gist.github.com/Tomcc/a96af509e275b1af483b25c543cfbf37?permalink_comment_id=3901255#gistcomment-3901255
+			// v9 - [version:byte][num_storages:byte][sub_chunk_index:byte][block storage1]...[blockStorageN]
+			header = buffer[3];
+			block_offset = 4;
+
+			break;
+		default:
+			log::error("Invalid SubChunk version found ({})",
+				buffer[0]);
+
+			return -1;
+		}
+
+		// The storage header is [bits per block:7][runtime flag:1]; the layout is looked up once per storage here
+		format = GetBlockStorageFormat(header);
+
+		if (format == nullptr) {
+			log::error("Unknown SubChunk palette value (value = {})", header);
+
+			return -1;
+		}
+
+		palette_offset = block_offset + format->word_count * 4;
+
+		return 0;
+	}
+} // namespace smokey_bedrock_parser
@@ -3,182 +3,235 @@
 #include <string>
 #include <cstring>
 #include <cstdint>
-#include <cmath>
 
-#include "json.hpp"
 #include "logger.h"
-#include "nbt.h"
-
-// Thanks to the project bedrock-viz for this math logic
-int32_t
-SetupBlockStorage(const char* buffer, int32_t& blocks_per_word, int32_t& bits_per_block, int32_t& block_offset,
-	int32_t& palette_offset) {
-	int32_t version = -1;
-	int32_t word_count = -1;
-
-	// Check sub-chunk version
-	switch (buffer[0]) {
-	case 0x01:
-		// v1 - [version:byte][block storage]
-		version = buffer[1];
-		block_offset = 1;
-
-		break;
-	case 0x08:
-		// v8 - [version:byte][num_storages:byte][block storage1]...[blockStorageN]
-		version = buffer[2];
-		block_offset = 3;
-
-		break;
-	case 0x09:
-		// https://gist.github.com/Tomcc/a96af509e275b1af483b25c543cfbf37?permalink_comment_id=3901255#gistcomment-3901255
-		// v9 - [version:byte][num_storages:byte][sub_chunk_index:byte][block storage1]...[blockStorageN]
-		version = buffer[3];
-		block_offset = 4;
-
-		break;
-	default:
-		smokey_bedrock_parser::log::error("Invalid SubChunk version found ({})",
-			buffer[0]);
-
-		return -1;
-	}
+#include "nbt_reader.h"
+#include "world/block_registry.h"
+#include "world/palette_cache.h"
+#include "world/block_storage.h"
 
-	switch (version) {
-	case 0x00:
-		// occasional 0 size bits per block
-		bits_per_block = 0;
-		blocks_per_word = 0;
-		palette_offset = 0;
-
-		break;
-	case 0x01:
-	case 0x02:
-	case 0x03:
-	case 0x04:
-	case 0x05:
-	case 0x06:
-	case 0x08:
-	case 0x0a:
-	case 0x0c:
-	case 0x10:
-	case 0x20:
-		bits_per_block = version >> 1;
-		blocks_per_word = floor(32.0 / bits_per_block);
-		word_count = ceil(4096.0 / blocks_per_word);
-		palette_offset = word_count * 4 + block_offset;
-
-		break;
-	default:
-		smokey_bedrock_parser::log::error("Unknown SubChunk palette value (value = {})", version);
-
-		return -1;
-	}
+namespace {
+	using namespace smokey_bedrock_parser;
+
+	// Interns one whole palette compound, header included. kInvalidBlockId if it has no block name.
+	uint32_t ResolvePaletteEntry(std::string_view entry) {
+		NbtReader reader(entry.data(), entry.size());
+		NbtTagType type;
+		std::string_view name;
+
+		if (!reader.ReadTagHeader(type, name) || type != NbtTagType::Compound) return kInvalidBlockId;
 
-	return 0;
-}
+		std::string_view block_name;
+		std::string_view block_states;
 
-int32_t GetBitFromByte(const char* buffer, int32_t bit_number) {
-	int byte_start = bit_number / 8;
-	int byte_offset = bit_number % 8;
+		reader.ForEachInCompound([&](NbtTagType child_type, std::string_view child_name) {
+			if (child_type == NbtTagType::String && child_name == "name")
+				return reader.ReadString(block_name);
 
-	return buffer[byte_start] & (1 << byte_offset);
-}
+			if (child_type == NbtTagType::Compound && child_name == "states") {
+				// Handed over raw, the registry only decodes states it has not seen byte for byte
+				const char* states_start = reader.data();
 
-int32_t GetBitsFromBytes8(const char* buffer, int32_t bit_start, int32_t bit_length)
-{
-	unsigned byte_start = bit_start / 8;
-	unsigned byte_offset = bit_start % 8;
-	uint8_t byte_low = buffer[byte_start];
-	uint8_t byte_high = buffer[byte_start + 1];
-	uint16_t value = byte_low + (byte_high << 8u);
-	value = value >> byte_offset;
-	uint16_t mask = (1u << unsigned(bit_length)) - 1;
+				if (!reader.SkipPayload(child_type)) return false;
 
-	return value & mask;
-}
+				block_states = std::string_view(states_start, reader.data() - states_start);
 
-int32_t GetBitsFromBytesLarge(const char* buffer, int32_t bit_start, int32_t bit_length)
-{
-	int32_t result = 0;
+				return true;
+			}
+
+			return reader.SkipPayload(child_type);
+		});
 
-	for (int b = 0; b < bit_length; b++) {
-		uint8_t bit = GetBitFromByte(buffer, bit_start + b);
+		if (!reader.ok() || block_name.empty()) return kInvalidBlockId;
 
-		if (bit) result |= 1 << b;
+		return BlockRegistry::Instance().Intern(block_name, block_states);
 	}
 
-	return result;
-}
+	/**
+		Reads one [header:byte][index words][palette_size:int32][palette compounds] block storage starting at
+		offset and leaves offset just past it.
+	*/
+	int32_t ReadBlockStorage(const char* buffer, size_t buffer_length, size_t& offset, BlockStorage& storage) {
+		if (offset >= buffer_length) {
+			log::error("SubChunk is truncated (size = {}, storage offset = {})", buffer_length, offset);
+
+			return -1;
+		}
 
-int32_t GetBitsFromBytes(const char* buffer, int32_t bit_start, int32_t bit_length)
-{
-	if (bit_length <= 8) return GetBitsFromBytes8(buffer, bit_start, bit_length);
+		storage.format = GetBlockStorageFormat(uint8_t(buffer[offset]));
+
+		if (storage.format == nullptr) {
+			log::error("Unknown SubChunk palette value (value = {})", uint8_t(buffer[offset]));
+
+			return -1;
+		}
+
+		size_t block_offset = offset + 1;
+		size_t palette_offset = block_offset + storage.format->word_count * 4;
+
+		if (palette_offset + 4 > buffer_length) {
+			log::error("SubChunk is truncated (size = {}, palette offset = {})", buffer_length, palette_offset);
+
+			return -1;
+		}
 
-	return GetBitsFromBytesLarge(buffer, bit_start, bit_length);
-}
+		storage.words.resize(storage.format->word_count);
+		memcpy(storage.words.data(), &buffer[block_offset], storage.format->word_count * 4);
 
-int32_t GetBlockId(const char* palette, int blocks_per_word, int bits_per_block,
-	int32_t x, int32_t z, int32_t y) {
-	int block_position = (((x * 16) + z) * 16) + y;
-	int word_start = block_position / blocks_per_word;
-	int bit_offset = (block_position % blocks_per_word) * bits_per_block;
-	int bit_start = word_start * 4 * 8 + bit_offset;
+		// [palette_size:int32][palette_size root compounds], read in place without building a tag tree
+		int32_t palette_size;
+		NbtReader reader(&buffer[palette_offset], buffer_length - palette_offset);
 
-	return GetBitsFromBytes(palette, bit_start, bits_per_block);
-}
+		if (!reader.ReadInt(palette_size)) {
+			log::error("Failed to read SubChunk palette size (palette offset = {})", palette_offset);
+
+			return -1;
+		}
+
+		// The size comes straight from disk, an empty compound ([type][name length:2][end]) is the smallest entry
+		// there is, so anything that cannot fit in what is left of the buffer is corrupt
+		const size_t min_entry_size = 4;
+
+		if (palette_size < 0 || size_t(palette_size) > (buffer_length - palette_offset - 4) / min_entry_size) {
+			log::error("SubChunk palette size out of range (palette size = {}, bytes left = {})", palette_size,
+				buffer_length - palette_offset - 4);
+
+			return -1;
+		}
+
+		storage.palette.assign(palette_size, kInvalidBlockId);
+
+		PaletteCache& cache = PaletteCache::ForThread();
+
+		for (int32_t i = 0; i < palette_size; i++) {
+			// Walking the entry to find its end is much cheaper than decoding it, so always do that first
+			const char* entry_start = reader.data();
+
+			if (!reader.SkipTag()) break;
+
+			std::string_view entry(entry_start, reader.data() - entry_start);
+			uint32_t block_id = cache.Find(entry);
+
+			if (block_id == kInvalidBlockId) {
+				block_id = ResolvePaletteEntry(entry);
+
+				if (block_id != kInvalidBlockId)
+					cache.Insert(entry, block_id);
+			}
+
+			storage.palette[i] = block_id;
+		}
+
+		if (!reader.ok()) {
+			log::error("Failed to read SubChunk palette (palette size = {})", palette_size);
+
+			return -1;
+		}
+
+		offset = palette_offset + reader.position();
+
+		return 0;
+	}
+} // namespace
 
 namespace smokey_bedrock_parser {
+	uint32_t Chunk::GetBlock(int32_t x, int32_t y, int32_t z, size_t layer) const {
+		int32_t chunk_y = y >> 4;
+
+		if (chunk_y < kMinSubChunk || chunk_y > kMaxSubChunk) return kInvalidBlockId;
+
+		const SubChunk& sub_chunk = sub_chunks[chunk_y - kMinSubChunk];
+
+		if (layer >= sub_chunk.storages.size()) return kInvalidBlockId;
+
+		const BlockStorage& storage = sub_chunk.storages[layer];
+		uint16_t palette_id = storage.GetIndex(x, y & 15, z);
+
+		if (palette_id >= storage.palette.size()) return kInvalidBlockId;
+
+		return storage.palette[palette_id];
+	}
+
 	int32_t Chunk::ParseChunk(int32_t chunk_x, int32_t chunk_y, int32_t chunk_z, const char* buffer, size_t buffer_length,
 		int32_t dimension_id, const std::string& dimension_name) {
 		// https://gist.github.com/Tomcc/a96af509e275b1af483b25c543cfbf37
-		int32_t blocks_per_word = -1;
-		int32_t bits_per_block = -1;
-		int32_t block_offset = -1;
-		int32_t palette_offset = -1;
+		SubChunk* sub_chunk = get_sub_chunk(chunk_y);
 
-		if (SetupBlockStorage(buffer, blocks_per_word, bits_per_block, block_offset, palette_offset) != 0) return -1;
+		if (sub_chunk == nullptr) {
+			log::error("SubChunk index out of range (index = {})", chunk_y);
 
-		NbtTagList tag_list;
-		int offset = palette_offset + 4;
-		NbtJson test;
-		test.name = "nbt";
+			return -1;
+		}
 
-		test.nbt = ParseNbt(" ", &buffer[offset], buffer_length - offset, tag_list).second;
-		//log::info("{}", test.nbt.dump(4, ' ', false, nlohmann::detail::error_handler_t::ignore));
+		int32_t storage_count;
+		size_t offset;
 
-		std::vector<std::string> chunk_palette_id(tag_list.size());
-		std::vector<int32_t> chunk_palette_data(tag_list.size());
+		if (buffer_length < 2) {
+			log::error("SubChunk is truncated (size = {})", buffer_length);
 
-		for (size_t i = 0; i < tag_list.size(); i++) {
-			if (tag_list[i].second->get_type() == nbt::tag_type::Compound) {
-				nbt::tag_compound tag_compound = tag_list[i].second->as<nbt::tag_compound>();
+			return -1;
+		}
 
-				if (tag_compound.has_key("name", nbt::tag_type::String)) {
-					chunk_palette_id[i] = tag_compound["name"].as<nbt::tag_string>().get();
+		// Check sub-chunk version
+		switch (buffer[0]) {
+		case 0x01:
+			// v1 - [version:byte][block storage]
+			storage_count = 1;
+			offset = 1;
+
+			break;
+		case 0x08:
+			// v8 - [version:byte][num_storages:byte][block storage1]...[blockStorageN]
+			storage_count = uint8_t(buffer[1]);
+			offset = 2;
+
+			break;
+		case 0x09:
+			// https://gist.github.com/Tomcc/a96af509e275b1af483b25c543cfbf37?permalink_comment_id=3901255#gistcomment-3901255
+			// v9 - [version:byte][num_storages:byte][sub_chunk_index:byte][block storage1]...[blockStorageN]
+			storage_count = uint8_t(buffer[1]);
+			offset = 3;
+
+			break;
+		default:
+			log::error("Invalid SubChunk version found ({})", buffer[0]);
+
+			return -1;
+		}
 
-					// TODO: Deal with block states later
-					/*if (tag_compound.has_key("states", nbt::tag_type::Compound)) {
-						nbt::tag_compound states = tag_compound["states"].as<nbt::tag_compound>();
-					}*/
-				}
+		sub_chunk->storages.assign(storage_count, BlockStorage());
+
+		for (BlockStorage& storage : sub_chunk->storages)
+			if (ReadBlockStorage(buffer, buffer_length, offset, storage) != 0) {
+				sub_chunk->storages.clear();
+
+				return -1;
 			}
-		}
 
-		int32_t palette_id, palette_data;
-		std::string block_id;
-		for (int32_t y = 0; y < 16; y++) {
-			for (int32_t z = 0; z < 16; z++) {
-				for (int32_t x = 0; x < 16; x++) {
-					if (blocks_per_word != 0 && bits_per_block != 0)
-						palette_id = GetBlockId(&buffer[block_offset], blocks_per_word, bits_per_block, x, z, y);
-					else
-						palette_id = 0;
-
-					block_id = chunk_palette_id[palette_id];
-					log::trace("Block ID: {}, (x: {}, y: {}, z: {})", block_id, x + chunk_x * 16, y + chunk_y * 16, z + chunk_z * 16);
+		// Palette indices are not checked here, that would mean unpacking all 4096 of them. GetBlock checks the ones it reads.
+		if (sub_chunk->empty()) return 0;
+
+		// Dumping every block is 4096 formatted lines per sub-chunk, only walk them when someone is listening
+		if (log::enabled(Level::Trace)) {
+			const BlockStorage& blocks = sub_chunk->storages[0];
+			const BlockRegistry& registry = BlockRegistry::Instance();
+			uint16_t block_indices[kBlockStorageSize];
+
+			blocks.Unpack(block_indices);
+
+			for (int32_t y = 0; y < 16; y++) {
+				for (int32_t z = 0; z < 16; z++) {
+					for (int32_t x = 0; x < 16; x++) {
+						uint16_t palette_id = block_indices[(((x * 16) + z) * 16) + y];
+						uint32_t block_id = palette_id < blocks.palette.size() ? blocks.palette[palette_id] : kInvalidBlockId;
+
+						SBP_LOG_TRACE("Block ID: {}, (x: {}, y: {}, z: {})", block_id == kInvalidBlockId ? std::string_view() : std::string_view(registry.get_name(block_id)),
+							x + chunk_x * 16, y + chunk_y * 16, z + chunk_z * 16);
+					}
 				}
 			}
 		}
+
+		return 0;
 	}
-} // namespace smokey_bedrock_parser
\ No newline at end of file
+} // namespace smokey_bedrock_parser
@@ -0,0 +1,33 @@
+#include "world/chunk_key.h"
+
+namespace {
+	int8_t ParseInt8(const char* p, int32_t startByte) {
+		return (p[startByte] & 0xff);
+	}
+} // namespace
+
+namespace smokey_bedrock_parser {
+	std::pair<bool, int32_t> IsChunkKey(std::string_view key) {
+		auto tag_test = [](char tag) {
+			return ((33 <= tag && tag <= 64) || tag == 118);
+			};
+
+		if (key.size() == 9 || key.size() == 10) return std::make_pair(tag_test(key[8]), ParseInt8(key.data(), 8));
+		else if (key.size() == 13 || key.size() == 14) return std::make_pair(tag_test(key[12]), ParseInt8(key.data(), 12));
+
+		return std::make_pair(false, 0);
+	}
+
+	const char* GetDimensionName(DimensionId dimension) {
+		switch (dimension) {
+		case DimensionId::Overworld:
+			return "overworld";
+		case DimensionId::Nether:
+			return "nether";
+		case DimensionId::TheEnd:
+			return "the-end";
+		default:
+			return "(UNKNOWN)";
+		}
+	}
+} // namespace smokey_bedrock_parser
@@ -0,0 +1,103 @@
+#include "world/chunk_map.h"
+
+namespace {
+	constexpr size_t initial_capacity = 1024;
+
+	// splitmix64 finalizer, spreads neighbouring coordinates over the whole table
+	uint64_t HashKey(uint64_t key) {
+		key ^= key >> 30;
+		key *= 0xbf58476d1ce4e5b9ULL;
+		key ^= key >> 27;
+		key *= 0x94d049bb133111ebULL;
+		key ^= key >> 31;
+
+		return key;
+	}
+} // namespace
+
+namespace smokey_bedrock_parser {
+	size_t ChunkMap::Probe(uint64_t key) const {
+		size_t mask = slots.size() - 1;
+		size_t index = HashKey(key) & mask;
+
+		while (slots[index] != 0 && keys[index] != key)
+			index = (index + 1) & mask;
+
+		return index;
+	}
+
+	Chunk* ChunkMap::Find(int32_t chunk_x, int32_t chunk_z) {
+		if (slots.empty()) return nullptr;
+
+		size_t index = Probe(PackKey(chunk_x, chunk_z));
+
+		if (slots[index] == 0 || !store_chunks) return nullptr;
+
+		return &chunk_at(slots[index] - 1);
+	}
+
+	std::pair<Chunk*, bool> ChunkMap::FindOrInsert(int32_t chunk_x, int32_t chunk_z) {
+		// Keep the load factor at or below one half so probe runs stay short
+		if ((chunk_count + 1) * 2 > slots.size())
+			Grow();
+
+		uint64_t key = PackKey(chunk_x, chunk_z);
+		size_t index = Probe(key);
+
+		if (slots[index] != 0)
+			return std::make_pair(store_chunks ? &chunk_at(slots[index] - 1) : nullptr, false);
+
+		keys[index] = key;
+		slots[index] = uint32_t(++chunk_count);
+
+		if (!store_chunks)
+			return std::make_pair(nullptr, true);
+
+		if ((chunk_count - 1) % kChunkBlockSize == 0)
+			chunk_blocks.push_back(std::make_unique<Chunk[]>(kChunkBlockSize));
+
+		Chunk& chunk = chunk_at(chunk_count - 1);
+		chunk.chunk_x = chunk_x;
+		chunk.chunk_z = chunk_z;
+
+		return std::make_pair(&chunk, true);
+	}
+
+	void ChunkMap::Merge(ChunkMap& other) {
+		for (size_t i = 0; i < other.slots.size(); i++) {
+			if (other.slots[i] == 0) continue;
+
+			uint64_t key = other.keys[i];
+			auto result = FindOrInsert(int32_t(uint32_t(key >> 32)), int32_t(uint32_t(key)));
+
+			if (result.second && result.first != nullptr && other.store_chunks)
+				*result.first = std::move(other.chunk_at(other.slots[i] - 1));
+		}
+
+		other.clear();
+	}
+
+	void ChunkMap::clear() {
+		keys.clear();
+		slots.clear();
+		chunk_blocks.clear();
+		chunk_count = 0;
+	}
+
+	void ChunkMap::Grow() {
+		size_t capacity = slots.empty() ? initial_capacity : slots.size() * 2;
+		std::vector<uint64_t> old_keys = std::move(keys);
+		std::vector<uint32_t> old_slots = std::move(slots);
+
+		keys.assign(capacity, 0);
+		slots.assign(capacity, 0);
+
+		for (size_t i = 0; i < old_slots.size(); i++) {
+			if (old_slots[i] == 0) continue;
+
+			size_t index = Probe(old_keys[i]);
+			keys[index] = old_keys[i];
+			slots[index] = old_slots[i];
+		}
+	}
+} // namespace smokey_bedrock_parser
@@ -0,0 +1,21 @@
+#include "world/palette_cache.h"
+
+namespace smokey_bedrock_parser {
+	PaletteCache& PaletteCache::ForThread() {
+		thread_local PaletteCache cache;
+
+		return cache;
+	}
+
+	uint64_t PaletteCache::Hash(std::string_view entry) {
+		// FNV-1a, palette entries are short enough that anything fancier does not pay off
+		uint64_t hash = 0xcbf29ce484222325ULL;
+
+		for (char c : entry) {
+			hash ^= uint8_t(c);
+			hash *= 0x100000001b3ULL;
+		}
+
+		return hash;
+	}
+} // namespace smokey_bedrock_parser
@@ -0,0 +1,178 @@
+#include "world/record_key.h"
+
+namespace {
+	using namespace smokey_bedrock_parser;
+
+	// Singleton records whose value is a plain NBT compound
+	constexpr std::string_view global_keys[] = {
+		"AutonomousEntities",
+		"BiomeData",
+		"Nether",
+		"Overworld",
+		"TheEnd",
+		"game_flatworldlayers",
+		"mobevents",
+		"portals",
+		"schedulerWT",
+		"scoreboard"
+	};
+
+	bool StartsWith(std::string_view key, std::string_view prefix) {
+		return key.size() >= prefix.size() && key.compare(0, prefix.size(), prefix) == 0;
+	}
+
+	bool IsAlpha(char c) {
+		return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+	}
+
+	bool IsUuidChar(char c) {
+		return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || c == '-';
+	}
+
+	// VILLAGE_[<dimension>_]<uuid>_<suffix>
+	RecordKey ClassifyVillageKey(std::string_view key) {
+		RecordKey record_key;
+		std::string_view rest = key.substr(8);
+		size_t suffix_start = rest.rfind('_');
+
+		if (suffix_start == std::string_view::npos) return record_key;
+
+		std::string_view id = rest.substr(0, suffix_start);
+		std::string_view suffix = rest.substr(suffix_start + 1);
+		size_t uuid_start = 0;
+		size_t dimension_end = id.find('_');
+
+		if (dimension_end != std::string_view::npos) {
+			if (dimension_end == 0) return record_key;
+
+			for (size_t i = 0; i < dimension_end; i++)
+				if (!IsAlpha(id[i])) return record_key;
+
+			uuid_start = dimension_end + 1;
+		}
+
+		if (uuid_start == id.size()) return record_key;
+
+		for (size_t i = uuid_start; i < id.size(); i++)
+			if (!IsUuidChar(id[i])) return record_key;
+
+		if (suffix == "INFO") record_key.kind = RecordKind::VillageInfo;
+		else if (suffix == "PLAYERS") record_key.kind = RecordKind::VillagePlayers;
+		else if (suffix == "DWELLERS") record_key.kind = RecordKind::VillageDwellers;
+		else if (suffix == "POI") record_key.kind = RecordKind::VillagePoi;
+		else return record_key;
+
+		record_key.name = id;
+
+		return record_key;
+	}
+} // namespace
+
+namespace smokey_bedrock_parser {
+	RecordKey ClassifyRecordKey(std::string_view key) {
+		RecordKey record_key;
+
+		if (key.empty()) return record_key;
+
+		// Named keys first: a short text key can look like a chunk key, a real chunk key never spells a prefix
+		switch (key[0]) {
+		case 'V':
+			if (StartsWith(key, "VILLAGE_")) return ClassifyVillageKey(key);
+
+			break;
+		case 'a':
+			if (key.size() == 19 && StartsWith(key, "actorprefix")) {
+				record_key.kind = RecordKind::Actor;
+
+				return record_key;
+			}
+
+			break;
+		case 'd':
+			if ((key.size() == 12 || key.size() == 16) && StartsWith(key, "digp")) {
+				record_key.kind = RecordKind::ActorDigest;
+
+				return record_key;
+			}
+
+			break;
+		case 'm':
+			if (StartsWith(key, "map_")) {
+				record_key.kind = RecordKind::Map;
+				record_key.name = key.substr(4);
+
+				return record_key;
+			}
+
+			break;
+		case 'p':
+			if (StartsWith(key, "player_server_")) {
+				record_key.kind = RecordKind::Player;
+				record_key.name = key.substr(14);
+
+				return record_key;
+			}
+
+			if (StartsWith(key, "player_")) {
+				record_key.kind = RecordKind::Player;
+				record_key.name = key.substr(7);
+
+				return record_key;
+			}
+
+			break;
+		case '~':
+			if (key == "~local_player") {
+				record_key.kind = RecordKind::LocalPlayer;
+
+				return record_key;
+			}
+
+			break;
+		default:
+			break;
+		}
+
+		for (std::string_view global_key : global_keys)
+			if (key == global_key) {
+				record_key.kind = RecordKind::Global;
+				record_key.name = key;
+
+				return record_key;
+			}
+
+		if (DecodeChunkKey(key, record_key.chunk))
+			record_key.kind = RecordKind::Chunk;
+
+		return record_key;
+	}
+
+	const char* GetRecordKindName(RecordKind kind) {
+		switch (kind) {
+		case RecordKind::Chunk:
+			return "chunk";
+		case RecordKind::Global:
+			return "global";
+		case RecordKind::LocalPlayer:
+			return "local-player";
+		case RecordKind::Player:
+			return "player";
+		case RecordKind::Map:
+			return "map";
+		case RecordKind::Actor:
+			return "actor";
+		case RecordKind::ActorDigest:
+			return "actor-digest";
+		case RecordKind::VillageInfo:
+			return "village-info";
+		case RecordKind::VillagePlayers:
+			return "village-players";
+		case RecordKind::VillageDwellers:
+			return "village-dwellers";
+		case RecordKind::VillagePoi:
+			return "village-poi";
+		default:
+			return "unknown";
+		}
+	}
+} // namespace smokey_bedrock_parser
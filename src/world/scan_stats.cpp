@@ -0,0 +1,190 @@
+#include "world/scan_stats.h"
+
+#include <algorithm>
+
+#include "logger.h"
+
+namespace smokey_bedrock_parser {
+	void Histogram::Merge(const Histogram& other) {
+		for (size_t i = 0; i < kBucketCount; i++)
+			buckets[i] += other.buckets[i];
+
+		count += other.count;
+		sum += other.sum;
+		min = std::min(min, other.min);
+		max = std::max(max, other.max);
+	}
+
+	uint64_t Histogram::Percentile(double fraction) const {
+		if (count == 0) return 0;
+
+		uint64_t target = uint64_t(fraction * count);
+		uint64_t seen = 0;
+
+		for (size_t i = 0; i < kBucketCount; i++) {
+			seen += buckets[i];
+
+			if (seen > target || seen == count)
+				return std::min(i == 0 ? 0 : (uint64_t(1) << i) - 1, max);
+		}
+
+		return max;
+	}
+
+	nlohmann::json Histogram::ToJson() const {
+		size_t last_bucket = kBucketCount;
+
+		while (last_bucket > 0 && buckets[last_bucket - 1] == 0)
+			last_bucket--;
+
+		return {
+			{ "count", count },
+			{ "sum", sum },
+			{ "min", count > 0 ? min : 0 },
+			{ "max", max },
+			{ "mean", count > 0 ? double(sum) / count : 0.0 },
+			{ "p50", Percentile(0.5) },
+			{ "p90", Percentile(0.9) },
+			{ "p99", Percentile(0.99) },
+			// buckets[i] counts values below 2^i, down to the previous bucket's bound
+			{ "buckets", std::vector<uint64_t>(buckets.begin(), buckets.begin() + last_bucket) }
+		};
+	}
+
+	nlohmann::json StageTime::ToJson() const {
+		return {
+			{ "count", count },
+			{ "seconds", seconds() }
+		};
+	}
+
+	uint64_t ScanStats::record_count() const {
+		uint64_t total = 0;
+
+		for (uint64_t count : records_by_kind)
+			total += count;
+
+		return total;
+	}
+
+	uint64_t ScanStats::bytes_decompressed() const {
+		uint64_t total = 0;
+
+		for (uint64_t bytes : bytes_by_kind)
+			total += bytes;
+
+		return total;
+	}
+
+	void ScanStats::Merge(const ScanStats& other) {
+		for (size_t i = 0; i < kRecordKindCount; i++) {
+			records_by_kind[i] += other.records_by_kind[i];
+			bytes_by_kind[i] += other.bytes_by_kind[i];
+		}
+
+		value_sizes.Merge(other.value_sizes);
+		bytes_read += other.bytes_read;
+		nbt_decode.Merge(other.nbt_decode);
+
+		for (size_t i = 0; i <= kMaxBitsPerBlock; i++)
+			sub_chunk_decode_by_bits[i].Merge(other.sub_chunk_decode_by_bits[i]);
+
+		sub_chunk_errors += other.sub_chunk_errors;
+		palette_sizes.Merge(other.palette_sizes);
+		palette_cache_hits += other.palette_cache_hits;
+		palette_cache_misses += other.palette_cache_misses;
+		count_phase.Merge(other.count_phase);
+		scan_phase.Merge(other.scan_phase);
+		actor_phase.Merge(other.actor_phase);
+		village_phase.Merge(other.village_phase);
+	}
+
+	nlohmann::json ScanStats::ToJson() const {
+		nlohmann::json records = nlohmann::json::object();
+
+		for (size_t i = 0; i < kRecordKindCount; i++) {
+			if (records_by_kind[i] == 0) continue;
+
+			records[GetRecordKindName(RecordKind(i))] = {
+				{ "count", records_by_kind[i] },
+				{ "bytes", bytes_by_kind[i] }
+			};
+		}
+
+		nlohmann::json sub_chunk_decode = nlohmann::json::object();
+
+		for (size_t bits = 0; bits <= kMaxBitsPerBlock; bits++)
+			if (sub_chunk_decode_by_bits[bits].count > 0)
+				sub_chunk_decode[std::to_string(bits)] = sub_chunk_decode_by_bits[bits].ToJson();
+
+		uint64_t palette_lookups = palette_cache_hits + palette_cache_misses;
+
+		return {
+			{ "records", records },
+			{ "record_count", record_count() },
+			{ "bytes_read", bytes_read },
+			{ "bytes_decompressed", bytes_decompressed() },
+			{ "value_sizes", value_sizes.ToJson() },
+			{ "nbt_decode", nbt_decode.ToJson() },
+			{ "sub_chunk_decode_by_bits_per_block", sub_chunk_decode },
+			{ "sub_chunk_errors", sub_chunk_errors },
+			{ "palette_sizes", palette_sizes.ToJson() },
+			{ "palette_cache", {
+				{ "hits", palette_cache_hits },
+				{ "misses", palette_cache_misses },
+				{ "hit_rate", palette_lookups > 0 ? double(palette_cache_hits) / palette_lookups : 0.0 }
+			} },
+			{ "phases", {
+				{ "count_records", count_phase.ToJson() },
+				{ "scan", scan_phase.ToJson() },
+				{ "actors", actor_phase.ToJson() },
+				{ "villages", village_phase.ToJson() }
+			} },
+			{ "leveldb", {
+				{ "block_cache_capacity", block_cache_capacity },
+				{ "block_cache_usage", block_cache_usage },
+				{ "approximate_memory_usage", approximate_memory_usage },
+				{ "stats", leveldb_stats }
+			} }
+		};
+	}
+
+	void ScanStats::LogSummary() const {
+		const double mb = 1024.0 * 1024.0;
+		double scan_seconds = scan_phase.seconds();
+
+		log::info("Scan: {} records, {:.1f} MB on disk, {:.1f} MB decompressed in {:.2f}s ({:.1f} MB/s)", record_count(),
+			bytes_read / mb, bytes_decompressed() / mb, scan_seconds, scan_seconds > 0.0 ? bytes_decompressed() / mb / scan_seconds : 0.0);
+
+		for (size_t i = 0; i < kRecordKindCount; i++)
+			if (records_by_kind[i] > 0)
+				log::info("  {:<16} {:>10} records {:>10.1f} MB", GetRecordKindName(RecordKind(i)), records_by_kind[i],
+					bytes_by_kind[i] / mb);
+
+		log::info("Phases: count {:.2f}s, scan {:.2f}s, actors {:.2f}s, villages {:.2f}s", count_phase.seconds(), scan_seconds,
+			actor_phase.seconds(), village_phase.seconds());
+		log::info("NBT decode: {} values in {:.2f}s (summed over threads)", nbt_decode.count, nbt_decode.seconds());
+
+		for (size_t bits = 0; bits <= kMaxBitsPerBlock; bits++) {
+			const StageTime& decode = sub_chunk_decode_by_bits[bits];
+
+			if (decode.count > 0)
+				log::info("Sub-chunk decode, {:>2} bits/block: {:>9} sub-chunks, {:.2f}s, {:.1f} us each", bits, decode.count,
+					decode.seconds(), decode.nanoseconds / 1e3 / decode.count);
+		}
+
+		if (sub_chunk_errors > 0)
+			log::info("Sub-chunk decode errors: {}", sub_chunk_errors);
+
+		uint64_t palette_lookups = palette_cache_hits + palette_cache_misses;
+
+		log::info("Palettes: {} storages, mean size {:.1f}, p99 <= {}, max {}; palette cache hit rate {:.1f}%", palette_sizes.count,
+			palette_sizes.count > 0 ? double(palette_sizes.sum) / palette_sizes.count : 0.0, palette_sizes.Percentile(0.99),
+			palette_sizes.max, palette_lookups > 0 ? 100.0 * palette_cache_hits / palette_lookups : 0.0);
+		log::info("LevelDB: block cache {:.1f} / {:.1f} MB, approximate memory usage {:.1f} MB", block_cache_usage / mb,
+			block_cache_capacity / mb, approximate_memory_usage / mb);
+
+		if (!leveldb_stats.empty())
+			log::debug("LevelDB stats:\n{}", leveldb_stats);
+	}
+} // namespace smokey_bedrock_parser
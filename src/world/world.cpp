@@ -6,222 +6,314 @@
 #include <leveldb/filter_policy.h>
 #include <leveldb/options.h>
 #include <leveldb/zlib_compressor.h>
-#include <regex>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
 
 #include "json.hpp"
 #include "logger.h"
 #include "nbt.h"
+#include "trace.h"
+#include "world/chunk_key.h"
+#include "world/palette_cache.h"
+#include "world/record_key.h"
+#include "world/scan_stats.h"
 
-int8_t ParseInt8(const char* p, int32_t startByte) {
-	return (p[startByte] & 0xff);
-}
+namespace {
+	class NullLogger : public leveldb::Logger {
+	public:
+		void Logv(const char*, va_list) override {}
+	};
 
-int32_t ParseInt32(const char* p, int32_t startByte) {
-	int32_t ret;
+	uint64_t NanosecondsSince(std::chrono::steady_clock::time_point start) {
+		return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
 
-	memcpy(&ret, &p[startByte], 4);
+	// Stores one record of a chunk loaded with LoadChunk
+	int32_t ParseChunkRecord(const smokey_bedrock_parser::ChunkKey& chunk_key, const leveldb::Slice& value,
+		smokey_bedrock_parser::Chunk& chunk) {
+		using namespace smokey_bedrock_parser;
 
-	return ret;
-}
+		int32_t dimension_id = int32_t(chunk_key.dimension);
 
-std::pair<bool, int32_t> IsChunkKey(std::string_view key) {
-	auto tag_test = [](char tag) {
-		return ((33 <= tag && tag <= 64) || tag == 118);
-		};
+		switch (chunk_key.tag) {
+		case ChunkTag::Version:
+		case ChunkTag::LegacyVersion:
+			if (!value.empty())
+				chunk.chunk_format_version = uint8_t(value[0]);
 
-	if (key.size() == 9 || key.size() == 10) return std::make_pair(tag_test(key[8]), ParseInt8(key.data(), 8));
-	else if (key.size() == 13 || key.size() == 14) return std::make_pair(tag_test(key[12]), ParseInt8(key.data(), 12));
+			return 0;
+		case ChunkTag::Data3D:
+			chunk.data_3d.assign(value.data(), value.size());
 
-	return std::make_pair(false, 0);
-}
+			return 0;
+		case ChunkTag::BlockEntity:
+			chunk.block_entities.assign(value.data(), value.size());
+
+			return 0;
+		case ChunkTag::SubChunkPrefix:
+			if (value.empty() || value[0] == 0) return 0;
 
-// https://learn.microsoft.com/en-us/minecraft/creator/documents/actorstorage
-enum class ChunkTag : char {
-	Data3D = 43,
-	Version, // This was moved to the front as needed for the extended heights feature. Old chunks will not have this data.
-	Data2D,
-	Data2DLegacy,
-	SubChunkPrefix,
-	LegacyTerrain,
-	BlockEntity,
-	Entity,
-	PendingTicks,
-	LegacyBlockExtraData,
-	BiomeState,
-	FinalizedState,
-	ConversionData, // data that the converter provides, that are used at runtime for things like blending
-	BorderBlocks,
-	HardcodedSpawners,
-	RandomTicks,
-	CheckSums,
-	GenerationSeed,
-	GeneratedPreCavesAndCliffsBlending = 61, // not used, DON'T REMOVE
-	BlendingBiomeHeight = 62, // not used, DON'T REMOVE
-	MetaDataHash,
-	BlendingData,
-	ActorDigestVersion,
-	LegacyVersion = 118,
-};
-
-struct ChunkData {
-	int32_t chunk_x;
-	int32_t chunk_z;
-	int32_t chunk_dimension_id;
-	ChunkTag chunk_tag;
-	int32_t chunk_type_sub;
-	std::string dimension_name;
-};
-
-ChunkData ParseChunkKey(std::string_view key) {
-	ChunkData chunk_data;
-
-	chunk_data.chunk_x = key[0];
-	chunk_data.chunk_z = key[4];
-	chunk_data.chunk_type_sub = 0;
-
-	switch (key.size()) {
-	case 9: {
-		chunk_data.chunk_dimension_id = 0;
-		chunk_data.dimension_name = "overworld";
-		chunk_data.chunk_tag = (ChunkTag)key[8];
+			return chunk.ParseChunk(chunk_key.chunk_x, chunk_key.sub_chunk, chunk_key.chunk_z, value.data(), value.size(),
+				dimension_id, GetDimensionName(chunk_key.dimension));
+		default:
+			return 0;
+		}
 	}
-		  break;
-	case 10: {
-		chunk_data.chunk_dimension_id = 0;
-		chunk_data.dimension_name = "overworld";
-		chunk_data.chunk_tag = (ChunkTag)key[8];
-		chunk_data.chunk_type_sub = key[9];
+}
+
+namespace smokey_bedrock_parser {
+	MinecraftWorldLevelDB::MinecraftWorldLevelDB() {
+		db = nullptr;
+		snapshot = nullptr;
+		total_record_count = 0;
+		parsed_record_count = 0;
+		total_approximate_size = 0;
+		exact_record_count = false;
+		keep_chunks = false;
+		thread_count = 1;
+		io_thread_count = 0;
+
+		for (int32_t i = 0; i < 3; i++) {
+			dimensions.push_back(std::make_unique<Dimension>());
+			dimensions[i]->set_dimension_id(i);
+			dimensions[i]->set_dimension_name(dimension_id_names[i]);
+			enabled_dimensions.push_back(true);
+		}
 	}
-		   break;
-	case 13: {
-		chunk_data.chunk_dimension_id = key[8];
-		chunk_data.dimension_name = "nether";
-		chunk_data.chunk_tag = (ChunkTag)key[12];
 
-		if (chunk_data.chunk_dimension_id == 0x32373639)
-			chunk_data.chunk_dimension_id = 2;
+	int32_t MinecraftWorldLevelDB::init(std::string db_directory) {
+		int32_t result = ParseLevelFile(std::string(db_directory + "/level.dat"));
 
-		if (chunk_data.chunk_dimension_id == 0x33373639)
-			chunk_data.chunk_dimension_id = 1;
+		if (result != 0) {
+			log::error("Failed to parse level.dat file.  Exiting...");
 
-		// check for new dim id's
-		if (chunk_data.chunk_dimension_id != 1 && chunk_data.chunk_dimension_id != 2)
-			smokey_bedrock_parser::log::warn("UNKNOWN -- Found new chunk dimension id=0x{:x} -- Did Bedrock finally get custom dimensions? Or did Mojang add a new dimension?", chunk_data.chunk_dimension_id);
-	}
-		   break;
-	case 14: {
-		chunk_data.chunk_dimension_id = key[8];
-		chunk_data.dimension_name = "nether";
-		chunk_data.chunk_tag = (ChunkTag)key[12];
-		chunk_data.chunk_type_sub = key[13];
-
-		if (chunk_data.chunk_dimension_id == 0x32373639)
-			chunk_data.chunk_dimension_id = 2;
-
-		if (chunk_data.chunk_dimension_id == 0x33373639)
-			chunk_data.chunk_dimension_id = 1;
-
-		// check for new dim id's
-		if (chunk_data.chunk_dimension_id != 1 && chunk_data.chunk_dimension_id != 2)
-			smokey_bedrock_parser::log::warn("UNKNOWN -- Found new chunk dimension id=0x{:x} -- Did Bedrock finally get custom dimensions? Or did Mojang add a new dimension?", chunk_data.chunk_dimension_id);
-	}
-		   break;
-	default:
-		break;
+			return -1;
+		}
+
+		result = ParseLevelName(std::string(db_directory + "/levelname.txt"));
+
+		if (result != 0)
+			log::warn("WARNING: Failed to parse levelname.txt file.");
+
+		return 0;
 	}
 
-	return chunk_data;
-}
+	int32_t MinecraftWorldLevelDB::OpenDB(std::string db_directory) {
+		trace::ScopedSpan span("OpenDB");
 
-namespace {
-	class NullLogger : public leveldb::Logger {
-	public:
-		void Logv(const char*, va_list) override {}
-	};
-}
+		log::info("DB Open: directory={}", db_directory);
+		CloseDB();
 
-namespace smokey_bedrock_parser {
-	MinecraftWorldLevelDB::MinecraftWorldLevelDB() {
-		db = nullptr;
 		db_options = std::make_unique<leveldb::Options>();
 
 		// create a bloom filter to quickly tell if a key is in the database or
 		// not
-		db_options->filter_policy = leveldb::NewBloomFilterPolicy(10);
+		filter_policy.reset(leveldb::NewBloomFilterPolicy(db_config.bloom_filter_bits_per_key));
+		db_options->filter_policy = filter_policy.get();
 
-		// create a 40 mb cache (we use this on ~1gb devices)
-		db_options->block_cache = leveldb::NewLRUCache(40 * 1024 * 1024);
+		block_cache.reset(leveldb::NewLRUCache(db_config.block_cache_size));
+		db_options->block_cache = block_cache.get();
 
-		// create a 4mb write buffer, to improve compression and touch the disk
-		// less
-		db_options->write_buffer_size = 4 * 1024 * 1024;
+		// a larger write buffer improves compression and touches the disk less
+		db_options->write_buffer_size = db_config.write_buffer_size;
 
 		// disable internal logging. The default logger will still print out
 		// things to a file
-		db_options->info_log = new NullLogger();
+		info_log = std::make_unique<NullLogger>();
+		db_options->info_log = info_log.get();
 
 		// use the new raw-zip compressor to write (and read)
-		auto zlib_raw_compressor = std::make_unique<leveldb::ZlibCompressorRaw>(-1);
+		zlib_raw_compressor = std::make_unique<leveldb::ZlibCompressorRaw>(-1);
 		db_options->compressors[0] = zlib_raw_compressor.get();
 
 		// also setup the old, slower compressor for backwards compatibility.
 		// This will only be used to read old compressed blocks.
-		auto zlib_compressor = std::make_unique<leveldb::ZlibCompressor>();
+		zlib_compressor = std::make_unique<leveldb::ZlibCompressor>();
 		db_options->compressors[1] = zlib_compressor.get();
 
-		// create a reusable memory space for decompression so it allocates less
-		leveldb::ReadOptions readOptions;
-		readOptions.decompress_allocator = new leveldb::DecompressAllocator();
+		// a reusable memory space for decompression so reads allocate less
+		if (db_config.reuse_decompress_buffers)
+			decompress_allocator = std::make_unique<leveldb::DecompressAllocator>();
+		else
+			decompress_allocator.reset();
 
-		for (int32_t i = 0; i < 3; i++) {
-			dimensions.push_back(std::make_unique<Dimension>());
-			dimensions[i]->set_dimension_id(i);
-			dimensions[i]->set_dimension_name(dimension_id_names[i]);
+		log::info("DB Options: block cache={} MB, bloom filter={} bits/key, fill cache on scan={}, verify checksums={}",
+			db_config.block_cache_size / (1024 * 1024), db_config.bloom_filter_bits_per_key, db_config.fill_cache_on_scan,
+			db_config.verify_checksums);
+
+		std::string db_path = db_directory + "/db";
+		leveldb::Status status;
+
+		if (db_config.read_only) {
+			// The server may compact and delete a table file between us listing and linking it, so give it a
+			// few tries before giving up
+			for (int32_t attempt = 0; attempt < 3; attempt++) {
+				snapshot_directory = CopyDBForReading(db_directory);
+
+				if (snapshot_directory.empty()) return -1;
+
+				status = leveldb::DB::Open(*db_options, snapshot_directory, &db);
+
+				if (status.ok()) break;
+
+				log::warn("Failed to open copy of live world (attempt {}): {}", attempt + 1, status.ToString());
+				CloseDB();
+			}
 		}
-	}
+		else
+			status = leveldb::DB::Open(*db_options, db_path, &db);
 
-	int32_t MinecraftWorldLevelDB::init(std::string db_directory) {
-		int32_t result = ParseLevelFile(std::string(db_directory + "/level.dat"));
+		log::info("DB Open Status: {}", status.ToString());
 
-		if (result != 0) {
-			log::error("Failed to parse level.dat file.  Exiting...");
+		if (!status.ok()) {
+			log::error("LevelDB operation returned status={}", status.ToString());
 
 			return -1;
 		}
 
-		result = ParseLevelName(std::string(db_directory + "/levelname.txt"));
-
-		if (result != 0)
-			log::warn("WARNING: Failed to parse levelname.txt file.");
+		if (db_config.read_only)
+			snapshot = db->GetSnapshot();
 
 		return 0;
 	}
 
-	int32_t MinecraftWorldLevelDB::OpenDB(std::string db_directory) {
-		log::info("DB Open: directory={}", db_directory);
-		db_options = std::make_unique<leveldb::Options>();
-		leveldb::Status status = leveldb::DB::Open(*db_options, std::string(db_directory + "/db").c_str(), &db);
-		log::info("DB Open Status: {}", status.ToString());
+	int32_t MinecraftWorldLevelDB::CloseDB() {
+		// Iterators must go before the DB they read from
+		{
+			std::lock_guard<std::mutex> lock(iterator_mutex);
 
-		if (!status.ok())
-			log::error("LevelDB operation returned status={}", status.ToString());
+			thread_iterators.clear();
+		}
+
+		if (db != nullptr) {
+			if (snapshot != nullptr)
+				db->ReleaseSnapshot(snapshot);
+
+			delete db;
+			db = nullptr;
+		}
+
+		snapshot = nullptr;
+
+		if (!snapshot_directory.empty()) {
+			std::error_code error;
+
+			std::filesystem::remove_all(snapshot_directory, error);
+			snapshot_directory.clear();
+		}
 
 		return 0;
 	}
 
+	std::string MinecraftWorldLevelDB::CopyDBForReading(const std::string& db_directory) {
+		namespace fs = std::filesystem;
+
+		std::error_code error;
+		fs::path source = fs::path(db_directory) / "db";
+		// Next to db rather than in the temp directory, hardlinks only work within one filesystem
+		fs::path target = fs::path(db_directory) /
+			(".smokey-bedrock-parser-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+		if (!fs::create_directories(target, error)) {
+			log::error("Failed to create snapshot directory (directory={} | error={})", target.string(), error.message());
+
+			return std::string();
+		}
+
+		// CURRENT names the manifest, so copy it before anything else to get a manifest that still exists
+		if (!fs::copy_file(source / "CURRENT", target / "CURRENT", error)) {
+			log::error("Failed to copy {} (error={})", (source / "CURRENT").string(), error.message());
+			fs::remove_all(target, error);
+
+			return std::string();
+		}
+
+		int32_t copied_tables = 0;
+		std::string link_error;
+
+		for (const fs::directory_entry& entry : fs::directory_iterator(source, error)) {
+			std::string name = entry.path().filename().string();
+			std::string extension = entry.path().extension().string();
+
+			if (name == "CURRENT" || name == "LOCK" || !entry.is_regular_file(error))
+				continue;
+
+			// Table files are never modified once written, so a hardlink is enough and costs no I/O. Everything
+			// else (manifest, logs) is still being appended to and gets copied; a torn record at the end of a
+			// copied log is dropped when LevelDB replays it.
+			bool table = extension == ".ldb" || extension == ".sst";
+
+			if (table) {
+				fs::create_hard_link(entry.path(), target / name, error);
+
+				if (!error) continue;
+
+				if (link_error.empty())
+					link_error = error.message();
+			}
+
+			error.clear();
+
+			if (fs::copy_file(entry.path(), target / name, error))
+				copied_tables += table ? 1 : 0;
+			else if (fs::exists(entry.path()))
+				log::warn("Failed to copy {} (error={})", entry.path().string(), error.message());
+		}
+
+		if (copied_tables > 0)
+			log::warn("Copied {} table files that could not be hardlinked, opening the world will take longer (error={})",
+				copied_tables, link_error);
+
+		log::info("Reading live world through a copy in {}", target.string());
+
+		return target.string();
+	}
+
+	leveldb::ReadOptions MinecraftWorldLevelDB::GetReadOptions(bool bulk_scan) {
+		leveldb::ReadOptions read_options;
+
+		read_options.fill_cache = !bulk_scan || db_config.fill_cache_on_scan;
+		read_options.verify_checksums = db_config.verify_checksums;
+		read_options.decompress_allocator = decompress_allocator.get();
+		read_options.snapshot = snapshot;
+
+		return read_options;
+	}
+
 	int32_t MinecraftWorldLevelDB::CalculateTotalRecords() {
+		trace::ScopedSpan span("CalculateTotalRecords");
 		int32_t record_count = 0;
-		leveldb::Slice key, value;
-		leveldb::Iterator* it = db->NewIterator(leveldb::ReadOptions());
+		leveldb::Iterator* it = db->NewIterator(GetReadOptions(true));
 
 		for (it->SeekToFirst(); it->Valid(); it->Next())
 			record_count++;
 
+		delete it;
+		span.set_arg("records", record_count);
+
 		total_record_count = record_count;
 
 		return 0;
 	}
 
+	uint64_t MinecraftWorldLevelDB::ApproximateSize(const std::string& start, const std::string& limit) {
+		// An empty limit means "past the last key". Keys are at most a few dozen bytes, so a long run of 0xff
+		// sorts after every real key.
+		static const std::string last_key(64, char(0xff));
+		leveldb::Range range(start, limit.empty() ? last_key : limit);
+		uint64_t size = 0;
+
+		db->GetApproximateSizes(&range, 1, &size);
+
+		return size;
+	}
+
 	int32_t MinecraftWorldLevelDB::ParseLevelFile(std::string file_name) {
 		FILE* file = fopen(file_name.c_str(), "rb");
 
@@ -238,7 +330,7 @@ namespace smokey_bedrock_parser {
 		fread(&buffer_length, sizeof(int32_t), 1, file);
 
 		log::info("ParseLevelFile: name={} version={} length={}", file_name, format_version, buffer_length);
-		std::pair<int32_t, nlohmann::json> result;
+		int32_t result = 0;
 
 		if (buffer_length > 0) {
 			char* buffer = new char[buffer_length];
@@ -246,12 +338,10 @@ namespace smokey_bedrock_parser {
 			fread(buffer, 1, buffer_length, file);
 			fclose(file);
 
-			NbtTagList tag_list;
+			result = ParseNbt("level.dat: ", buffer, buffer_length, level_tags);
 
-			result = ParseNbt("level.dat: ", buffer, buffer_length, tag_list);
-
-			if (result.first == 0) {
-				nbt::tag_compound tag_compound = tag_list[0].second->as<nbt::tag_compound>();
+			if (result == 0) {
+				nbt::tag_compound tag_compound = level_tags[0].second->as<nbt::tag_compound>();
 				set_world_spawn_x(tag_compound["SpawnX"].as<nbt::tag_int>().get());
 				set_world_spawn_y(tag_compound["SpawnY"].as<nbt::tag_int>().get());
 				set_world_spawn_z(tag_compound["SpawnZ"].as<nbt::tag_int>().get());
@@ -268,182 +358,839 @@ namespace smokey_bedrock_parser {
 		}
 		else fclose(file);
 
-		return result.first;
+		return result;
 	}
 
-	int32_t MinecraftWorldLevelDB::ParseDB() {
-		char temp_string[256];
-		log::info("Parsing all leveldb records");
+	// A half-open slice of the keyspace, [start, limit). An empty start means the first key and an empty limit
+	// means past the last key.
+	struct MinecraftWorldLevelDB::KeyRange {
+		std::string start;
+		std::string limit;
+		uint64_t approximate_size = 0;
+	};
 
-		CalculateTotalRecords();
+	// Shared between all scan workers. Progress is measured in approximate on-disk bytes: every so often a worker
+	// asks LevelDB how much of its key range lies before its current key, which only touches SST index blocks.
+	// Messages go through a single reporter so the log sees one line per second however many workers there are.
+	struct MinecraftWorldLevelDB::ScanProgress {
+		std::atomic<int32_t> record_count;
+		std::vector<std::atomic<uint64_t>> range_bytes;
+		ProgressReporter reporter;
+
+		explicit ScanProgress(size_t range_count) : record_count(0), range_bytes(range_count) {
+			for (auto& bytes : range_bytes)
+				bytes = 0;
+		}
 
-		NbtTagList tag_list;
-		int32_t record_count = 0, result;
-		leveldb::Slice key, value;
-		size_t key_size;
-		size_t value_size;
-		const char* key_name;
-		const char* key_data;
-		std::string chunk_string;
+		uint64_t bytes_done() const {
+			uint64_t total = 0;
+
+			for (const auto& bytes : range_bytes)
+				total += bytes.load(std::memory_order_relaxed);
+
+			return total;
+		}
+	};
+
+	// Everything a single scan worker produces. Each worker owns its own dimensions so that chunk parsing never
+	// needs a lock; the results are merged once all workers have finished.
+	struct MinecraftWorldLevelDB::ScanResult {
+		std::vector<std::unique_ptr<Dimension>> dimensions;
 		std::vector<std::string> villages;
 		std::vector<uint64_t> actor_ids;
-		leveldb::Iterator* it = db->NewIterator(leveldb::ReadOptions());
-
-		// Village Regex
-		const std::regex village_dweller_regex("VILLAGE_[0-9a-f\\-]+_DWELLERS");
-		const std::regex village_info_regex("VILLAGE_[A-Za-z]+_[0-9a-f\\-]+_INFO");
-		const std::regex village_player_regex("VILLAGE_[0-9a-f\\-]+_PLAYERS");
-		const std::regex village_poi_regex("VILLAGE_[0-9a-f\\-]+_POI");
-		const std::regex map_regex("map_\\-[0-9]+");
-
-		for (it->SeekToFirst(); it->Valid(); it->Next()) {
-			key = it->key();
-			key_size = (int)key.size();
-			key_name = key.data();
-			value = it->value();
-			value_size = value.size();
-			key_data = value.data();
-			record_count++;
-
-			if ((record_count % 100) == 0) {
-				double percentage = (double)record_count / (double)total_record_count;
-				log::info("Processing records: {} / {} ({:.1f}%)", record_count, total_record_count, percentage * 100.0);
+		int32_t record_count = 0;
+		ScanStats stats;
+		// Sub-chunks are decoded into this one when the scan does not keep chunks
+		Chunk scratch_chunk;
+
+		ScanResult() {
+			for (int32_t i = 0; i < 3; i++) {
+				dimensions.push_back(std::make_unique<Dimension>());
+				dimensions[i]->set_dimension_id(i);
+				dimensions[i]->set_dimension_name(dimension_id_names[i]);
 			}
+		}
+	};
 
-			/**
-				Sources for keys: https://minecraft.wiki/w/Bedrock_Edition_level_format
-				Sources for more NBT data: https://minecraft.wiki/w/Bedrock_Edition_level_format/Other_data_format
-			*/;
-			if (strncmp(key_name, "BiomeData", key_size) == 0) {
-				log::info("Found key - BiomeData");
+	// Records copied out of the iterator into one arena, so a batch costs a couple of allocations at most and
+	// the buffers are reused once the batch has been decoded
+	struct MinecraftWorldLevelDB::RecordBatch {
+		struct Record {
+			size_t key_offset;
+			size_t key_size;
+			size_t value_offset;
+			size_t value_size;
+		};
+
+		std::string arena;
+		std::vector<Record> records;
+
+		void Add(const leveldb::Slice& key, const leveldb::Slice& value) {
+			records.push_back({ arena.size(), key.size(), arena.size() + key.size(), value.size() });
+			arena.append(key.data(), key.size());
+			arena.append(value.data(), value.size());
+		}
+
+		leveldb::Slice key(const Record& record) const {
+			return leveldb::Slice(arena.data() + record.key_offset, record.key_size);
+		}
 
-				ParseNbt("BiomeData: ", key_data, int32_t(value_size), tag_list);
+		leveldb::Slice value(const Record& record) const {
+			return leveldb::Slice(arena.data() + record.value_offset, record.value_size);
+		}
+
+		void clear() {
+			arena.clear();
+			records.clear();
+		}
+	};
+
+	/**
+		Hands batches from the iterator threads to the decode workers. There is a fixed number of batches: the
+		iterator threads block in AcquireFree once all of them are waiting to be decoded, which bounds memory and
+		keeps a fast disk from racing ahead of the workers.
+	*/
+	struct MinecraftWorldLevelDB::BatchQueue {
+		std::mutex mutex;
+		std::condition_variable full_ready;
+		std::condition_variable free_ready;
+		std::deque<RecordBatch*> full;
+		std::vector<RecordBatch*> free;
+		std::vector<std::unique_ptr<RecordBatch>> batches;
+		size_t running_producers;
+
+		BatchQueue(size_t batch_count, size_t producer_count) : running_producers(producer_count) {
+			for (size_t i = 0; i < batch_count; i++) {
+				batches.push_back(std::make_unique<RecordBatch>());
+				free.push_back(batches.back().get());
 			}
-			else if (strncmp(key_name, "Overworld", key_size) == 0) {
-				log::info("Found key - Overworld");
+		}
+
+		RecordBatch* AcquireFree() {
+			std::unique_lock<std::mutex> lock(mutex);
+
+			free_ready.wait(lock, [this]() { return !free.empty(); });
+
+			RecordBatch* batch = free.back();
+
+			free.pop_back();
+
+			return batch;
+		}
 
-				ParseNbt("Overworld: ", key_data, int32_t(value_size), tag_list);
+		void PushFull(RecordBatch* batch) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				full.push_back(batch);
 			}
-			else if (strncmp(key_name, "~local_player", key_size) == 0) {
-				log::info("Found key - ~local_player");
 
-				ParseNbt("Local Player: ", key_data, int32_t(value_size), tag_list);
+			full_ready.notify_one();
+		}
+
+		// nullptr once every producer is done and nothing is left to decode
+		RecordBatch* PopFull() {
+			std::unique_lock<std::mutex> lock(mutex);
+
+			full_ready.wait(lock, [this]() { return !full.empty() || running_producers == 0; });
+
+			if (full.empty()) return nullptr;
+
+			RecordBatch* batch = full.front();
+
+			full.pop_front();
+
+			return batch;
+		}
+
+		void Release(RecordBatch* batch) {
+			batch->clear();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				free.push_back(batch);
 			}
-			else if ((key_size >= 7) && (strncmp(key_name, "player_", 7) == 0)) {
-				std::string player_remote_Id = std::string(&key_name[strlen("player_")], key_size - strlen("player_"));
-				log::info("Found key - player_{}", player_remote_Id);
 
-				ParseNbt("Remote Player: ", key_data, int32_t(key_data), tag_list);
+			free_ready.notify_one();
+		}
+
+		void ProducerDone() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				running_producers--;
 			}
-			else if (strncmp(key_name, "game_flatworldlayers", key_size) == 0) {
-				log::info("Found key - game_flatworldlayers");
 
-				ParseNbt("game_flatworldlayers: ", key_data, int32_t(value_size), tag_list);
+			full_ready.notify_all();
+		}
+	};
+
+	std::vector<MinecraftWorldLevelDB::KeyRange> MinecraftWorldLevelDB::SplitKeyRanges(int32_t range_count) {
+		std::vector<KeyRange> key_ranges;
+
+		if (range_count <= 1) {
+			key_ranges.push_back(KeyRange());
+
+			return key_ranges;
+		}
+
+		/**
+			Chunk keys start with the little-endian chunk x coordinate, so the first key byte is spread fairly evenly
+			over the whole byte range. Split the keyspace into one bucket per leading byte, ask LevelDB how much disk
+			each bucket uses, and then hand out runs of neighbouring buckets of roughly equal size. Splitting only on
+			the first byte guarantees that all records of a chunk land in the same range.
+		*/
+		const int32_t bucket_count = 256;
+		std::vector<std::string> bounds(bucket_count + 1);
+
+		for (int32_t i = 1; i < bucket_count; i++)
+			bounds[i] = std::string(1, char(i));
+
+		bounds[bucket_count] = std::string(64, char(0xff));
+
+		std::vector<leveldb::Range> ranges(bucket_count);
+		std::vector<uint64_t> sizes(bucket_count, 0);
+
+		for (int32_t i = 0; i < bucket_count; i++)
+			ranges[i] = leveldb::Range(bounds[i], bounds[i + 1]);
+
+		db->GetApproximateSizes(ranges.data(), bucket_count, sizes.data());
+
+		uint64_t total_size = 0;
+
+		for (uint64_t size : sizes)
+			total_size += size;
+
+		// Everything still lives in the memtable/log, fall back to an even split of the byte range
+		if (total_size == 0) {
+			std::fill(sizes.begin(), sizes.end(), 1);
+			total_size = bucket_count;
+		}
+
+		uint64_t accumulated = 0;
+		KeyRange current;
+
+		for (int32_t i = 0; i < bucket_count; i++) {
+			accumulated += sizes[i];
+			current.approximate_size += sizes[i];
+
+			uint64_t target = total_size * (key_ranges.size() + 1) / range_count;
+
+			if (accumulated >= target && (int32_t)key_ranges.size() < range_count - 1 && i < bucket_count - 1) {
+				current.limit = bounds[i + 1];
+				key_ranges.push_back(current);
+				current = KeyRange();
+				current.start = bounds[i + 1];
 			}
-			else if (strncmp(key_name, "VILLAGE_", 8) == 0) {
-				log::info("Found key - Village-{}", key.ToString());
-				char village_id[37];
-				char dimension_name[9];
+		}
+
+		key_ranges.push_back(current);
+
+		return key_ranges;
+	}
+
+	int32_t MinecraftWorldLevelDB::ScanKeyRange(size_t range_index, const KeyRange& range, BatchQueue& queue, ScanProgress& progress) {
+		// Big enough to amortize the queue hand-off, small enough that every worker gets a share of a small world
+		const size_t batch_bytes = 1024 * 1024;
+		const size_t batch_records = 4096;
+
+		trace::SetThreadName("reader " + std::to_string(range_index));
+		trace::ScopedSpan span("Read key range");
 
-				memcpy(dimension_name, key_name + 8, 9);
+		leveldb::Iterator* it = db->NewIterator(GetReadOptions(true));
+		leveldb::Slice limit(range.limit);
+		RecordBatch* batch = queue.AcquireFree();
+		int32_t range_record_count = 0;
+		ChunkKey last_chunk_key;
+		bool last_is_chunk = false;
 
-				memcpy(village_id, key_name + sizeof(dimension_name) + 9, 36);
+		if (range.start.empty())
+			it->SeekToFirst();
+		else
+			it->Seek(range.start);
 
-				log::info("Village ID-{}", village_id);
+		for (; it->Valid(); it->Next()) {
+			leveldb::Slice key = it->key();
 
-				if (std::regex_match(key.ToString(), village_info_regex))
-					villages.push_back(std::string((std::string)dimension_name + "_" + (std::string)village_id));
+			if (!limit.empty() && key.compare(limit) >= 0)
+				break;
+
+			int32_t count = ++progress.record_count;
+			range_record_count++;
+
+			if (exact_record_count) {
+				if (progress.reporter.ShouldReport()) {
+					double percentage = (double)count / (double)total_record_count;
+					log::info("Processing records: {} / {} ({:.1f}%)", count, total_record_count, percentage * 100.0);
+				}
 			}
-			else if (strncmp(key_name, "AutonomousEntities", key_size) == 0) {
-				log::info("Found key - AutonomousEntities");
+			else if ((range_record_count % 1000) == 0 && total_approximate_size > 0) {
+				progress.range_bytes[range_index] = ApproximateSize(range.start, key.ToString());
 
-				ParseNbt("AutonomousEntities: ", key_data, int32_t(value_size), tag_list);
+				double percentage = std::min(1.0, (double)progress.bytes_done() / (double)total_approximate_size);
+
+				if (percentage > 0.0 && progress.reporter.ShouldReport())
+					log::info("Processing records: {} / ~{} ({:.1f}%)", count, (int64_t)(count / percentage), percentage * 100.0);
 			}
-			else if (strncmp(key_name, "digp", 4) == 0) {
-				for (uint32_t i = 0; i < value_size; i += 8)
-					actor_ids.push_back(*(uint64_t*)(key_data + i));
+
+			/**
+				Workers merge their chunks at the end and a chunk must come from exactly one of them, so a full batch
+				is only handed off between two different chunks. Chunk records are adjacent in key order, so a batch
+				overshoots by at most one chunk's worth of records.
+			*/
+			ChunkKey chunk_key;
+			bool is_chunk = DecodeChunkKey({ key.data(), key.size() }, chunk_key);
+			bool same_chunk = is_chunk && last_is_chunk && chunk_key.chunk_x == last_chunk_key.chunk_x &&
+				chunk_key.chunk_z == last_chunk_key.chunk_z && chunk_key.dimension == last_chunk_key.dimension;
+
+			if (!same_chunk && (batch->arena.size() >= batch_bytes || batch->records.size() >= batch_records)) {
+				queue.PushFull(batch);
+
+				// Shows up when the decode workers cannot keep up
+				trace::ScopedSpan wait_span("Wait for free batch");
+
+				batch = queue.AcquireFree();
 			}
-			else if (strncmp(key_name, "actorprefix", 11) == 0) {
-				log::info("Found key - actorprefix");
 
-				ParseNbt("actorprefix: ", key_data, int32_t(value_size), tag_list);
+			batch->Add(key, it->value());
+			last_chunk_key = chunk_key;
+			last_is_chunk = is_chunk;
+		}
+
+		if (batch->records.empty())
+			queue.Release(batch);
+		else
+			queue.PushFull(batch);
+
+		log::debug("Key range {}: {} records (~{} bytes)", range_index, range_record_count, range.approximate_size);
+		span.set_arg("records", range_record_count);
+
+		int32_t status = 0;
+
+		if (!it->status().ok()) {
+			log::warn("LevelDB operation returned status={}", it->status().ToString());
+			status = -1;
+		}
+
+		delete it;
+
+		return status;
+	}
+
+	void MinecraftWorldLevelDB::DecodeBatches(BatchQueue& queue, ScanResult& result) {
+		const PaletteCache& palette_cache = PaletteCache::ForThread();
+		uint64_t palette_hits = palette_cache.get_hit_count();
+		uint64_t palette_misses = palette_cache.get_miss_count();
+
+		while (RecordBatch* batch = queue.PopFull()) {
+			trace::ScopedSpan span("Decode batch");
+
+			span.set_arg("records", int64_t(batch->records.size()));
+
+			for (const RecordBatch::Record& record : batch->records) {
+				ParseRecord(batch->key(record), batch->value(record), result);
+				result.record_count++;
 			}
-			else if (IsChunkKey({ key_name,key_size }).first) {
-				ChunkData chunk_data = ParseChunkKey({ key_name, key_size });
-				chunk_string = chunk_data.dimension_name + "-chunk: ";
 
-				sprintf(temp_string, "%d %d (type=0x%02x) (subtype=0x%02x) (size=%d)", chunk_data.chunk_x, chunk_data.chunk_z, chunk_data.chunk_tag,
-					chunk_data.chunk_type_sub, (int32_t)value_size);
+			queue.Release(batch);
+		}
 
-				chunk_string += temp_string;
-				log::info("{}", chunk_string);
+		result.stats.palette_cache_hits += palette_cache.get_hit_count() - palette_hits;
+		result.stats.palette_cache_misses += palette_cache.get_miss_count() - palette_misses;
+	}
+
+	int32_t MinecraftWorldLevelDB::ParseRecord(const leveldb::Slice& key, const leveldb::Slice& value, ScanResult& result) {
+		NbtTagList tag_list;
+		size_t key_size = key.size();
+		size_t value_size = value.size();
+		const char* key_data = value.data();
+
+		/**
+			Sources for keys: https://minecraft.wiki/w/Bedrock_Edition_level_format
+			Sources for more NBT data: https://minecraft.wiki/w/Bedrock_Edition_level_format/Other_data_format
+		*/
+		RecordKey record_key = ClassifyRecordKey({ key.data(), key_size });
+		ScanStats& stats = result.stats;
+
+		stats.records_by_kind[size_t(record_key.kind)]++;
+		stats.bytes_by_kind[size_t(record_key.kind)] += key_size + value_size;
+		stats.value_sizes.Add(value_size);
+
+		auto parse_nbt = [&](const char* log_prefix) {
+			auto start_time = std::chrono::steady_clock::now();
+
+			ParseNbt(log_prefix, key_data, int32_t(value_size), tag_list);
+			stats.nbt_decode.Add(NanosecondsSince(start_time));
+		};
+
+		switch (record_key.kind) {
+		case RecordKind::Chunk: {
+			const ChunkKey& chunk_key = record_key.chunk;
+			int32_t dimension_id = int32_t(chunk_key.dimension);
+
+			if (dimension_id < 0 || dimension_id >= int32_t(result.dimensions.size())) {
+				SBP_LOG_WARN("Skipping chunk record with unknown dimension (dimension id = {}, x = {}, z = {})", dimension_id,
+					chunk_key.chunk_x, chunk_key.chunk_z);
+
+				return 0;
+			}
+
+			if (!is_dimension_enabled(dimension_id))
+				return 0;
+
+			SBP_LOG_INFO("{}-chunk: {} {} (type=0x{:02x}) (subtype=0x{:02x}) (size={})", GetDimensionName(chunk_key.dimension),
+				chunk_key.chunk_x, chunk_key.chunk_z, uint8_t(chunk_key.tag), uint8_t(chunk_key.sub_chunk), value_size);
+
+			if (chunk_key.tag == ChunkTag::SubChunkPrefix && value_size > 0 && key_data[0] != 0) {
+				Dimension& dimension = *result.dimensions[dimension_id];
+				Chunk* chunk = dimension.AddChunk(chunk_key.chunk_x, chunk_key.chunk_z);
+				// Still decoded when chunks are not kept, to validate it and for the stats, then dropped again
+				Chunk& target = chunk != nullptr ? *chunk : result.scratch_chunk;
+				auto start_time = std::chrono::steady_clock::now();
+
+				if (target.ParseChunk(chunk_key.chunk_x, chunk_key.sub_chunk, chunk_key.chunk_z, key_data, value_size, dimension_id,
+					dimension.get_dimension_name()) != 0) {
+					stats.sub_chunk_errors++;
 
-				switch (chunk_data.chunk_tag) {
-				case ChunkTag::SubChunkPrefix: {
-					if (key_data[0] != 0)
-						dimensions[chunk_data.chunk_dimension_id]->AddChunk(7, chunk_data.chunk_x, chunk_data.chunk_type_sub, chunk_data.chunk_z, key_data, value_size);
-				}
-											 break;
-				default:
 					break;
 				}
+
+				uint64_t elapsed = NanosecondsSince(start_time);
+				SubChunk* sub_chunk = target.get_sub_chunk(chunk_key.sub_chunk);
+
+				if (sub_chunk->empty()) break;
+
+				// Filed under the block layer's width, which is what the unpacking cost depends on
+				size_t bits_per_block = size_t(sub_chunk->storages[0].format->bits_per_block);
+
+				stats.sub_chunk_decode_by_bits[std::min(bits_per_block, ScanStats::kMaxBitsPerBlock)].Add(elapsed);
+
+				for (const BlockStorage& storage : sub_chunk->storages)
+					stats.palette_sizes.Add(storage.palette.size());
+
+				if (chunk == nullptr)
+					sub_chunk->storages.clear();
 			}
-			else log::info("Unknown record - key_size={} value_size={}", key_size, value_size);
+
+			break;
 		}
+		case RecordKind::Global:
+			SBP_LOG_INFO("Found key - {}", record_key.name);
 
-		NbtJson test;
-		test.name = "nbt";
+			parse_nbt("Global: ");
 
-		for (auto actor_id : actor_ids) {
-			std::string data;
-			char key[19] = "actorprefix";
+			break;
+		case RecordKind::LocalPlayer:
+			SBP_LOG_INFO("Found key - ~local_player");
+
+			parse_nbt("Local Player: ");
+
+			break;
+		case RecordKind::Player:
+			SBP_LOG_INFO("Found key - player_{}", record_key.name);
+
+			parse_nbt("Remote Player: ");
+
+			break;
+		case RecordKind::VillageInfo:
+			SBP_LOG_INFO("Found key - Village-{}", record_key.name);
+
+			// The other village records are looked up from the INFO one once the scan is done
+			result.villages.emplace_back(record_key.name);
+
+			break;
+		case RecordKind::VillagePlayers:
+		case RecordKind::VillageDwellers:
+		case RecordKind::VillagePoi:
+			break;
+		case RecordKind::ActorDigest:
+			for (size_t i = 0; i + 8 <= value_size; i += 8) {
+				uint64_t actor_id;
+
+				memcpy(&actor_id, key_data + i, 8);
+				result.actor_ids.push_back(actor_id);
+			}
+
+			break;
+		case RecordKind::Actor:
+			// Decoded once by LoadActors, which finds every actor through the digp records
+			SBP_LOG_INFO("Found key - actorprefix");
+
+			break;
+		case RecordKind::Map:
+			SBP_LOG_INFO("Found key - map_{}", record_key.name);
 
-			memcpy(key + 11, &actor_id, 8);
+			break;
+		default:
+			SBP_LOG_INFO("Unknown record - key_size={} value_size={}", key_size, value_size);
 
-			NbtTagList actor_list;
-			leveldb::ReadOptions read_options;
+			break;
+		}
+
+		return 0;
+	}
+
+	int32_t MinecraftWorldLevelDB::ParseDB() {
+		trace::ScopedSpan span("ParseDB");
 
-			db->Get(read_options, leveldb::Slice(key, 19), &data);
+		log::info("Parsing all leveldb records");
+
+		scan_stats = ScanStats();
+
+		auto phase_start = std::chrono::steady_clock::now();
 
-			//log::info("{}", ParseNbt("actorprefix: ", data.data(), data.size(), actor_list).second[0].dump(4, ' ', false, nlohmann::detail::error_handler_t::ignore));
+		if (exact_record_count) {
+			CalculateTotalRecords();
+			scan_stats.count_phase.Add(NanosecondsSince(phase_start));
 		}
 
+		total_approximate_size = ApproximateSize(std::string(), std::string());
+		scan_stats.bytes_read = total_approximate_size;
+		log::info("Approximate world size: {:.1f} MB", total_approximate_size / (1024.0 * 1024.0));
+
+		int32_t worker_count = thread_count > 0 ? thread_count : (int32_t)std::max(1u, std::thread::hardware_concurrency());
+		int32_t reader_count = io_thread_count > 0 ? io_thread_count : std::max(1, worker_count / 4);
+		std::vector<KeyRange> key_ranges = SplitKeyRanges(reader_count);
+		std::vector<ScanResult> scan_results(worker_count);
+
+		for (auto& dimension : dimensions)
+			dimension->set_keep_chunks(keep_chunks);
+
+		for (ScanResult& scan_result : scan_results)
+			for (auto& dimension : scan_result.dimensions)
+				dimension->set_keep_chunks(keep_chunks);
+
+		std::vector<int32_t> scan_status(key_ranges.size(), 0);
+		ScanProgress progress(key_ranges.size());
+		// Two batches per worker keeps every worker busy while the readers fill the next ones
+		BatchQueue queue(2 * worker_count + key_ranges.size(), key_ranges.size());
+
+		log::info("Scanning world with {} reader thread(s) and {} decode thread(s)", key_ranges.size(), worker_count);
+
+		phase_start = std::chrono::steady_clock::now();
+
+		{
+			trace::ScopedSpan scan_span("Scan");
+			std::vector<std::thread> threads;
+
+			for (size_t i = 0; i < key_ranges.size(); i++)
+				threads.emplace_back([&, i]() {
+					scan_status[i] = ScanKeyRange(i, key_ranges[i], queue, progress);
+					queue.ProducerDone();
+				});
+
+			for (size_t i = 0; i < scan_results.size(); i++)
+				threads.emplace_back([&, i]() {
+					trace::SetThreadName("decode " + std::to_string(i));
+					DecodeBatches(queue, scan_results[i]);
+				});
+
+			for (auto& thread : threads)
+				thread.join();
+		}
+
+		scan_stats.scan_phase.Add(NanosecondsSince(phase_start));
+
+		// Batches reach the workers in no particular order, sort so the output does not depend on scheduling
+		std::vector<std::string> villages;
+		std::vector<uint64_t> actor_ids;
+
+		for (size_t i = 0; i < scan_results.size(); i++) {
+			ScanResult& scan_result = scan_results[i];
+
+			log::debug("Decode worker {}: {} records", i, scan_result.record_count);
+
+			for (size_t dimension = 0; dimension < dimensions.size(); dimension++)
+				dimensions[dimension]->Merge(*scan_result.dimensions[dimension]);
+
+			scan_stats.Merge(scan_result.stats);
+			villages.insert(villages.end(), scan_result.villages.begin(), scan_result.villages.end());
+			actor_ids.insert(actor_ids.end(), scan_result.actor_ids.begin(), scan_result.actor_ids.end());
+		}
+
+		std::sort(villages.begin(), villages.end());
+		std::sort(actor_ids.begin(), actor_ids.end());
+
+		phase_start = std::chrono::steady_clock::now();
+
+		int32_t actor_status = LoadActors(actor_ids, worker_count);
+
+		scan_stats.actor_phase.Add(NanosecondsSince(phase_start));
+		phase_start = std::chrono::steady_clock::now();
+
+		AssembleVillages(villages);
+
+		scan_stats.village_phase.Add(NanosecondsSince(phase_start));
+
+		parsed_record_count = progress.record_count.load();
+		log::info("Read {} records", parsed_record_count);
+
+		// LevelDB keeps no hit counters for its block cache, how full it is is the closest it gets
+		std::string property;
+
+		scan_stats.block_cache_capacity = db_config.block_cache_size;
+		scan_stats.block_cache_usage = block_cache->TotalCharge();
+
+		if (db->GetProperty("leveldb.approximate-memory-usage", &property))
+			scan_stats.approximate_memory_usage = strtoull(property.c_str(), nullptr, 10);
+
+		if (db->GetProperty("leveldb.stats", &property))
+			scan_stats.leveldb_stats = property;
+
+		scan_stats.LogSummary();
+
+		if (actor_status < 0)
+			return -1;
+
+		for (int32_t status : scan_status)
+			if (status != 0)
+				return -1;
+
+		return 0;
+	}
+
+	int32_t MinecraftWorldLevelDB::LoadActors(const std::vector<uint64_t>& actor_ids, int32_t worker_count) {
+		trace::ScopedSpan span("Actor lookups");
+		const size_t batch_records = 4096;
+
+		// actorprefix<id:int64>, sorted the way LevelDB orders them so the iterator only ever moves forward
+		std::vector<std::string> keys;
+		char key_data[19] = "actorprefix";
+
+		keys.reserve(actor_ids.size());
+
+		for (uint64_t actor_id : actor_ids) {
+			memcpy(key_data + 11, &actor_id, 8);
+			keys.emplace_back(key_data, 19);
+		}
+
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+		BatchQueue queue(2 * worker_count, 1);
+		std::vector<int32_t> decoded_counts(worker_count, 0);
+		std::vector<StageTime> decode_times(worker_count);
+		std::vector<std::thread> threads;
+
+		for (int32_t i = 0; i < worker_count; i++)
+			threads.emplace_back([&, i]() {
+				trace::SetThreadName("actor decode " + std::to_string(i));
+
+				while (RecordBatch* batch = queue.PopFull()) {
+					trace::ScopedSpan batch_span("Decode actors");
+
+					batch_span.set_arg("actors", int64_t(batch->records.size()));
+
+					for (const RecordBatch::Record& record : batch->records) {
+						leveldb::Slice value = batch->value(record);
+						NbtTagList actor_tags;
+						auto start_time = std::chrono::steady_clock::now();
+
+						if (ParseNbt("actorprefix: ", value.data(), int32_t(value.size()), actor_tags) == 0)
+							decoded_counts[i]++;
+
+						decode_times[i].Add(NanosecondsSince(start_time));
+					}
+
+					queue.Release(batch);
+				}
+			});
+
+		leveldb::Iterator* it = db->NewIterator(GetReadOptions(true));
+		RecordBatch* batch = queue.AcquireFree();
+		int32_t found_count = 0;
+		bool positioned = false;
+
+		for (const std::string& key : keys) {
+			// Actors of one chunk usually have neighbouring IDs, so the iterator is often already on the next one
+			if (!positioned || (it->Valid() && it->key().compare(key) < 0)) {
+				it->Seek(key);
+				positioned = true;
+			}
+
+			if (!it->Valid()) break;
+
+			// Listed in a digp record but never written, or already removed again
+			if (it->key().compare(key) != 0) continue;
+
+			if (batch->records.size() >= batch_records) {
+				queue.PushFull(batch);
+				batch = queue.AcquireFree();
+			}
+
+			batch->Add(it->key(), it->value());
+			found_count++;
+			it->Next();
+		}
+
+		if (batch->records.empty())
+			queue.Release(batch);
+		else
+			queue.PushFull(batch);
+
+		queue.ProducerDone();
+
+		for (auto& thread : threads)
+			thread.join();
+
+		int32_t decoded_count = 0;
+
+		for (int32_t count : decoded_counts)
+			decoded_count += count;
+
+		for (const StageTime& decode_time : decode_times)
+			scan_stats.nbt_decode.Merge(decode_time);
+
+		span.set_arg("actors", found_count);
+		log::info("Loaded {} of {} actors ({} decoded)", found_count, keys.size(), decoded_count);
+
+		int32_t status = found_count;
+
+		if (!it->status().ok()) {
+			log::warn("LevelDB operation returned status={}", it->status().ToString());
+			status = -1;
+		}
+
+		delete it;
+
+		return status;
+	}
+
+	void MinecraftWorldLevelDB::AssembleVillages(const std::vector<std::string>& villages) {
+		trace::ScopedSpan span("Village assembly");
+
+		span.set_arg("villages", int64_t(villages.size()));
+
 		for (auto& village_id : villages) {
 			std::string data;
 			NbtTagList tags_info, tags_player, tags_dweller, tags_poi;
-			leveldb::ReadOptions read_options;
+			leveldb::ReadOptions read_options = GetReadOptions(false);
 			db->Get(read_options, ("VILLAGE_" + village_id + "_INFO"), &data);
-			result = ParseNbt("village_info: ", data.data(), data.size(), tags_info).first;
+			int32_t result = ParseNbt("village_info: ", data.data(), data.size(), tags_info);
 
 			if (result != 0) continue;
 
 			db->Get(read_options, ("VILLAGE_" + village_id + "_PLAYERS"), &data);
-			result = ParseNbt("village_players: ", data.data(), data.size(), tags_player).first;
+			result = ParseNbt("village_players: ", data.data(), data.size(), tags_player);
 
 			if (result != 0) continue;
 
 			db->Get(read_options, ("VILLAGE_" + village_id + "_DWELLERS"), &data);
-			result = ParseNbt("village_dwellers: ", data.data(), data.size(), tags_dweller).first;
+			result = ParseNbt("village_dwellers: ", data.data(), data.size(), tags_dweller);
 
 			if (result != 0) continue;
 
 			db->Get(read_options, ("VILLAGE_" + village_id + "_POI"), &data);
-			result = ParseNbt("village_poi: ", data.data(), data.size(), tags_poi).first;
+			result = ParseNbt("village_poi: ", data.data(), data.size(), tags_poi);
 
 			if (result != 0) continue;
 
 			ParseNbtVillage(tags_info, tags_player, tags_dweller, tags_poi);
 		}
+	}
+
+	leveldb::Iterator* MinecraftWorldLevelDB::GetThreadIterator() {
+		std::lock_guard<std::mutex> lock(iterator_mutex);
+		std::unique_ptr<leveldb::Iterator>& it = thread_iterators[std::this_thread::get_id()];
+
+		if (it == nullptr)
+			it.reset(db->NewIterator(GetReadOptions(false)));
+
+		return it.get();
+	}
+
+	int32_t MinecraftWorldLevelDB::ReadChunkRecords(leveldb::Iterator* it, const leveldb::Slice& prefix, DimensionId dimension,
+		Chunk& chunk) {
+		int32_t record_count = 0;
 
-		log::info("Read {} records", record_count);
-		log::info("Status: {}", it->status().ToString());
+		for (; it->Valid() && it->key().starts_with(prefix); it->Next()) {
+			leveldb::Slice key = it->key();
+			ChunkKey chunk_key;
 
-		if (!it->status().ok())
+			// The overworld prefix is also the start of the other dimensions' keys for the same chunk
+			if (!DecodeChunkKey({ key.data(), key.size() }, chunk_key) || chunk_key.dimension != dimension)
+				continue;
+
+			ParseChunkRecord(chunk_key, it->value(), chunk);
+			record_count++;
+		}
+
+		return record_count;
+	}
+
+	int32_t MinecraftWorldLevelDB::LoadChunk(DimensionId dimension, int32_t chunk_x, int32_t chunk_z, Chunk& chunk) {
+		char prefix_data[12];
+		leveldb::Slice prefix(prefix_data, EncodeChunkKeyPrefix(dimension, chunk_x, chunk_z, prefix_data));
+		leveldb::Iterator* it = GetThreadIterator();
+
+		// A reused chunk must not keep sub-chunks or block entities this one does not have
+		chunk.clear();
+		chunk.chunk_x = chunk_x;
+		chunk.chunk_z = chunk_z;
+
+		it->Seek(prefix);
+
+		int32_t record_count = ReadChunkRecords(it, prefix, dimension, chunk);
+
+		if (!it->status().ok()) {
 			log::warn("LevelDB operation returned status={}", it->status().ToString());
 
-		delete it;
+			return -1;
+		}
 
-		return 0;
+		return record_count;
+	}
+
+	int32_t MinecraftWorldLevelDB::ScanRegion(DimensionId dimension, int32_t min_x, int32_t min_z, int32_t max_x, int32_t max_z,
+		const std::function<void(const Chunk& chunk)>& callback) {
+		if (min_x > max_x || min_z > max_z) return 0;
+
+		// Coordinates are little-endian, so key order is nothing like coordinate order; sort the prefixes instead
+		std::vector<std::string> prefixes;
+		char prefix_data[12];
+
+		prefixes.reserve(size_t(int64_t(max_x) - min_x + 1) * size_t(int64_t(max_z) - min_z + 1));
+
+		for (int64_t x = min_x; x <= max_x; x++)
+			for (int64_t z = min_z; z <= max_z; z++)
+				prefixes.emplace_back(prefix_data, EncodeChunkKeyPrefix(dimension, int32_t(x), int32_t(z), prefix_data));
+
+		std::sort(prefixes.begin(), prefixes.end());
+
+		// Not the thread's shared iterator: a callback that calls LoadChunk would move it under our feet
+		std::unique_ptr<leveldb::Iterator> it(db->NewIterator(GetReadOptions(false)));
+		Chunk chunk;
+		int32_t chunk_count = 0;
+		bool positioned = false;
+
+		for (const std::string& prefix : prefixes) {
+			// Only seek when the iterator is still short of this chunk; when the previous chunk's records run
+			// straight into this one, or past it, the iterator is already where it needs to be
+			if (!positioned || (it->Valid() && it->key().compare(prefix) < 0)) {
+				it->Seek(prefix);
+				positioned = true;
+			}
+
+			if (!it->Valid()) break;
+
+			chunk.clear();
+			memcpy(&chunk.chunk_x, prefix.data(), 4);
+			memcpy(&chunk.chunk_z, prefix.data() + 4, 4);
+
+			if (ReadChunkRecords(it.get(), prefix, dimension, chunk) > 0) {
+				callback(chunk);
+				chunk_count++;
+			}
+		}
+
+		if (!it->status().ok()) {
+			log::warn("LevelDB operation returned status={}", it->status().ToString());
+
+			return -1;
+		}
+
+		return chunk_count;
 	}
 
 	std::unique_ptr<MinecraftWorldLevelDB> world;